@@ -1,20 +1,87 @@
 // fast_cachebench.cpp — quick AIDA-like L1/L2/L3/Memory benchmark
-// Build: g++ -O3 -march=native -std=c++17 fast_cachebench.cpp -o cachebench
+// Build: g++ -O3 -march=native -std=c++17 -pthread fast_cachebench.cpp -o cachebench
 // Run (very fast): ./cachebench --quick
-// Tunables: --iters N (bandwidth loops), --stride B, --l1KB X --l2KB Y --l3KB Z --memKB M
+// Tunables: --iters N (min repetitions), --target-ms T, --ci PCT, --stats, --stride B, --l1KB X --l2KB Y --l3KB Z --memKB M
+//           --threads N|all (pinned bandwidth threads), --kernel scalar|sse|avx2|avx512|neon
+//           --sweep [--sweep-minKB N --sweep-maxKB N --ppo N] (size/latency/bandwidth curve)
+//           --mlp [--mlp-max K --mlpKB N] (K interleaved pointer chases)
+//           --pages 4k|thp|2m|1g (buffer page size + latency comparison)
+//           --numa [--numaKB N] (CPU node x memory node latency/bandwidth matrix)
+//           --timer auto|chrono|tsc|cntvct, --cycles (latency in core cycles)
+//           --counters (perf_event cycles/IPC/cache/TLB/DRAM counts per access)
+//           --format text|json|csv, --compare baseline.json [--tolerance PCT]
+//           --loaded [--loaded-threads N --loaded-traffic read|write|copy --loaded-delays ...]
+//           --patterns [--pattern-stride B] (seq/stride/random/page/gather read+write)
+//           --prefetch [--prefetchKB N --prefetch-dists D,...] (hardware/software prefetch)
+//           --c2c [--c2c-cpus LIST --c2c-padding B,...] (ping-pong, contention, false sharing)
+//           --atomics (store / exchange / fetch_add / CAS per tier, uncontended + contended)
+//           --io FILE [--ioMB N] (mmap cold/warm/advised, pread, O_DIRECT vs DRAM)
+//           --faults [--faultMB N] (first-touch, MAP_POPULATE, DONTNEED refault per page size)
+//           --alloc [--alloc-ops N] (malloc / posix_memalign / arena / pool workloads)
+//           --layout [--layout-fields N --layout-field-bytes B --layout-block L] (AoS/SoA/AoSoA)
+//           --structs (open-addressing / chained hash, B-tree 64/256/4096 B nodes, lists)
+//           --copy [--copy-maxKB N --copy-align-size B --copy-misalign LIST] (memcpy shoot-out)
+//           --stream [--rw R:W,...] (STREAM Copy/Scale/Add/Triad + R:W mixes per tier)
+//           --tlb [--tlb-pages N --tlb-huge-pages N] (one line per page: DTLB/STLB/walk reach)
+//           --assoc [--assoc-max-stride B --assoc-max-n N] (effective ways, set indexing)
+//           --monitor [--monitor-interval S --monitor-count N --monitor-budget PCT --monitor-nice N
+//                      --monitor-format jsonl|prom --monitor-out FILE --monitorKB N] (daemon probes)
+//           --tkernel NAME,...|PREFIX*|all, --list-kernels (type / unroll / stride template variants)
+//           --rdt, --resctrl GROUP, --cat-mask HEX, --mba PCT (Intel RDT CAT/MBA, MBM/CMT readout)
+//           --only LIST, --skip LIST, --all, --time-budget SEC, --pipeline (compose suites in one run)
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <chrono>
+#include <cctype>
+#include <cerrno>
 #include <cmath>
+#include <csignal>
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <ctime>
 #include <iomanip>
+#include <fstream>
+#include <functional>
 #include <iostream>
+#include <mutex>
 #include <random>
 #include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/utsname.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#define CB_X86 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(__APPLE__)
+#include <sys/sysctl.h>
+#include <mach/thread_act.h>
+#include <mach/vm_statistics.h>
+#include <mach/thread_policy.h>
+#endif
 using namespace std;
 //====================================================
 // Aligned memory allocation
@@ -31,6 +98,174 @@ static void free_aligned(void* p)
     free(p);
 }
 
+//====================================================
+// Page-size aware buffers (--pages)
+//====================================================
+#if defined(__linux__)
+#ifndef MAP_HUGE_2MB
+#define MAP_HUGE_2MB (21 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MAP_HUGE_1GB
+#define MAP_HUGE_1GB (30 << MAP_HUGE_SHIFT)
+#endif
+#ifndef MADV_POPULATE_WRITE
+#define MADV_POPULATE_WRITE 23
+#endif
+#endif
+
+enum class PageKind
+{
+    Default,                        // posix_memalign, whatever the OS hands out
+    Small,                          // 4 KB (THP explicitly disabled)
+    THP,                            // transparent huge pages via madvise
+    Huge2M,                         // hugetlbfs / superpage 2 MB
+    Huge1G                          // hugetlbfs 1 GB
+};
+
+struct Buffer
+{
+    char* p = nullptr;
+    size_t bytes = 0;               // mapped length
+    PageKind kind = PageKind::Default;
+};
+
+static const char* page_kind_name(PageKind k)
+{
+    switch (k)
+    {
+        case PageKind::Small:  return "4k";
+        case PageKind::THP:    return "thp";
+        case PageKind::Huge2M: return "2m";
+        case PageKind::Huge1G: return "1g";
+        default:               return "default";
+    }
+}
+
+static bool parse_page_kind(const string& s, PageKind& k)
+{
+    for (PageKind c : { PageKind::Default, PageKind::Small, PageKind::THP,
+                        PageKind::Huge2M, PageKind::Huge1G })
+    {
+        if (s == page_kind_name(c)) { k = c; return true; }
+    }
+    return false;
+}
+
+static size_t round_up(size_t v, size_t a)
+{
+    return (v + a - 1) / a * a;
+}
+
+// Returns an empty Buffer if the requested page size is unavailable (e.g.
+// no hugetlb pages reserved); callers decide whether to fall back. With
+// `populate` (Linux only) every page is faulted in before returning:
+// MAP_POPULATE for hugetlb, MADV_POPULATE_WRITE (5.14+) otherwise, so THP
+// is populated with huge pages; an empty Buffer if that is unsupported.
+static Buffer alloc_buffer(size_t bytes, PageKind kind, bool populate = false)
+{
+    Buffer b;
+    b.kind = kind;
+    if (kind == PageKind::Default)
+    {
+        if (populate) return b;
+        b.bytes = bytes;
+        b.p = (char*)alloc_aligned(bytes, 1ULL << 21);
+        return b;
+    }
+#if defined(__linux__)
+    const size_t huge = (kind == PageKind::Huge1G) ? (1ULL << 30) : (1ULL << 21);
+    if (kind == PageKind::Huge2M || kind == PageKind::Huge1G)
+    {
+        b.bytes = round_up(bytes, huge);
+        int flags = MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB |
+                    (kind == PageKind::Huge1G ? MAP_HUGE_1GB : MAP_HUGE_2MB) |
+                    (populate ? MAP_POPULATE : 0);
+        void* p = mmap(nullptr, b.bytes, PROT_READ | PROT_WRITE, flags, -1, 0);
+        b.p = (p == MAP_FAILED) ? nullptr : (char*)p;
+        return b;
+    }
+
+    // Over-map so the region starts on a 2 MB boundary; THP can only back
+    // aligned 2 MB extents.
+    b.bytes = round_up(bytes, huge);
+    size_t len = b.bytes + huge;
+    void* raw = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) return b;
+    char* p = (char*)round_up((uintptr_t)raw, huge);
+    if (p > (char*)raw) munmap(raw, p - (char*)raw);
+    size_t tail = (char*)raw + len - (p + b.bytes);
+    if (tail) munmap(p + b.bytes, tail);
+    madvise(p, b.bytes, kind == PageKind::THP ? MADV_HUGEPAGE : MADV_NOHUGEPAGE);
+    if (populate && madvise(p, b.bytes, MADV_POPULATE_WRITE) != 0)
+    {
+        munmap(p, b.bytes);
+        return b;
+    }
+    b.p = p;
+#elif defined(__APPLE__)
+    if (populate) return b;
+    if (kind == PageKind::Huge2M)
+    {
+        // Superpages exist on Intel Macs only; Apple Silicon fails here.
+        b.bytes = round_up(bytes, 1ULL << 21);
+        void* p = mmap(nullptr, b.bytes, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE,
+                       VM_FLAGS_SUPERPAGE_SIZE_2MB, 0);
+        b.p = (p == MAP_FAILED) ? nullptr : (char*)p;
+    }
+    else if (kind == PageKind::Small)
+    {
+        b.bytes = round_up(bytes, (size_t)getpagesize());
+        void* p = mmap(nullptr, b.bytes, PROT_READ | PROT_WRITE, MAP_ANON | MAP_PRIVATE, -1, 0);
+        b.p = (p == MAP_FAILED) ? nullptr : (char*)p;
+    }
+#endif
+    return b;
+}
+
+static void free_buffer(Buffer& b)
+{
+    if (!b.p) return;
+    if (b.kind == PageKind::Default) free_aligned(b.p);
+    else munmap(b.p, b.bytes);
+    b.p = nullptr;
+}
+
+// Describes the pages actually backing a (touched) buffer, from
+// /proc/self/smaps on Linux; elsewhere reports what was requested.
+static string describe_pages(const Buffer& b)
+{
+#if defined(__linux__)
+    FILE* f = fopen("/proc/self/smaps", "r");
+    if (!f) return page_kind_name(b.kind);
+    char line[512];
+    bool in = false;
+    size_t kernelKB = 0, thpKB = 0, sizeKB = 0;
+    uintptr_t p = (uintptr_t)b.p;
+    while (fgets(line, sizeof(line), f))
+    {
+        uintptr_t lo, hi;
+        if (sscanf(line, "%lx-%lx ", &lo, &hi) == 2 && strchr(line, '-') < strchr(line, ' '))
+        {
+            if (in) break;
+            in = (p >= lo && p < hi);
+            continue;
+        }
+        if (!in) continue;
+        sscanf(line, "Size: %zu kB", &sizeKB);
+        sscanf(line, "KernelPageSize: %zu kB", &kernelKB);
+        sscanf(line, "AnonHugePages: %zu kB", &thpKB);
+    }
+    fclose(f);
+    if (kernelKB >= 2048) return "hugetlb " + to_string(kernelKB) + " KB pages";
+    string s = to_string(kernelKB) + " KB pages";
+    if (thpKB)
+        s += ", THP " + to_string(thpKB >> 10) + " of " + to_string(sizeKB >> 10) + " MB";
+    return s;
+#else
+    return page_kind_name(b.kind);
+#endif
+}
+
 //====================================================
 // Global variables and types
 //====================================================
@@ -39,23 +274,521 @@ static volatile uint64_t sink64 = 0;
 
 struct Args 
 {
-    int iters = 3;                  // repetitions per tier
+    int iters = 3;                  // minimum repetitions per metric
+    double targetMs = 0;            // time budget per metric (0 = 100, quick 20)
+    double ciPct = 1.0;             // stop once the 95% CI is within this %
+    bool stats = false;             // print min/median/p95/stddev per metric
     size_t stride = 64;             // stride for latency test
-    size_t l1KB = 32;               // L1 size in KB
-    size_t l2KB = 512;              // L2 size in KB
-    size_t l3KB = 8192;             // L3 size in KB
-    size_t memKB = 131072;          // DRAM (128 MB default)
+    size_t l1KB = 0;                // L1 size in KB (0 = from detected caches)
+    size_t l2KB = 0;                // L2 size in KB (0 = from detected caches)
+    size_t l3KB = 0;                // L3 size in KB (0 = from detected caches)
+    size_t memKB = 0;               // DRAM (0 = max(128 MB, 4x L3))
+    int threads = 1;                // bandwidth threads (0 = all CPUs)
+    string kernel = "auto";         // read/write kernel ISA
     bool quick = false;             // quick mode
+    bool sweep = false;             // log-spaced working-set sweep
+    size_t sweepMinKB = 4;          // first sweep size
+    size_t sweepMaxKB = 0;          // last sweep size (0 = memKB)
+    int ppo = 4;                    // sweep points per octave
+    bool mlp = false;               // memory-level-parallelism test
+    int mlpMax = 32;                // largest number of interleaved chains
+    size_t mlpKB = 0;               // MLP working set (0 = memKB)
+    PageKind pages = PageKind::Default; // backing page size for the buffers
+    string timer = "auto";          // auto | chrono | tsc | cntvct
+    bool cycles = false;            // also report latency in core cycles
+    string format = "text";         // text | json | csv
+    string compare;                 // baseline JSON to diff against
+    double tolerancePct = 10.0;     // allowed regression per metric
+    bool patterns = false;          // access-pattern library per tier
+    size_t patternStride = 256;     // stride of the strided pattern (bytes)
+    bool prefetch = false;          // prefetcher characterization suite
+    size_t prefetchKB = 0;          // prefetch working set (0 = memKB)
+    string prefetchDists = "0,1,2,4,8,16,32,64";
+    bool c2c = false;               // core-to-core coherence suite
+    string c2cCpus;                 // CPU list for --c2c (empty = all allowed)
+    string c2cPadding = "8,16,32,64,128,256";
+    string ioPath;                  // --io: file for the I/O tier
+    size_t ioMB = 0;                // MB to create / read (0 = create 256, read all)
+    bool faults = false;            // page-fault / first-touch cost
+    size_t faultMB = 0;             // buffer size per fault test (0 = 1024, quick 256)
+    bool alloc = false;             // allocator workloads
+    uint64_t allocOps = 0;          // ops per sample (0 = 200000, quick 50000)
+    bool layout = false;            // AoS / SoA / AoSoA traversal suite
+    size_t layoutFields = 8;        // fields per record
+    size_t layoutFieldBytes = 8;    // bytes per field (multiple of 4)
+    size_t layoutBlock = 8;         // AoSoA records per block (power of two)
+    bool structs = false;           // hash table / B-tree / list traversal suite
+    bool copy = false;              // memcpy / memset shoot-out
+    size_t copyMaxKB = 0;           // largest sweep size (0 = memKB)
+    size_t copyAlignSize = 4096;    // size of the misalignment sweep (bytes)
+    string copyMisalign = "0-63";   // src/dst offsets for the misalignment sweep
+    bool atomics = false;           // atomic RMW kernels per tier
+    bool counters = false;          // perf_event counters around benchTier regions
+    bool tlb = false;               // TLB reach sweep, one line per page
+    size_t tlbPages = 0;            // largest 4 KB page count (0 = 32768, quick 8192)
+    size_t tlbHugePages = 0;        // largest huge page count (0 = 512, quick 128)
+    bool assoc = false;             // associativity / set-conflict detection
+    size_t assocMaxStride = 1 << 20; // largest power-of-two stride (bytes)
+    int assocMaxN = 0;              // lines per stride (0 = 2 x max ways + 2)
+    bool monitor = false;           // periodic low-duty latency / read probes
+    double monitorInterval = 60;    // seconds between probes
+    uint64_t monitorCount = 0;      // probes to take (0 = until SIGINT/SIGTERM)
+    double monitorBudgetPct = 1.0;  // process CPU time cap, % of wall time
+    int monitorNice = 10;           // setpriority() niceness for the monitor
+    string monitorFormat = "jsonl"; // jsonl | prom
+    string monitorOut;              // output file (jsonl: stdout if empty)
+    size_t monitorKB = 0;           // probe buffer (0 = memKB)
+    string only;                    // --only: suites to run (replaces the flag selection)
+    string skip;                    // --skip: suites to drop from the selection
+    bool all = false;               // every suite that needs no extra argument
+    double timeBudgetSec = 0;       // skip suites whose estimate no longer fits (0 = no limit)
+    bool pipeline = false;          // prepare the next suite's rings on an idle core
+    bool rdt = false;               // report resctrl allocation + MBM/CMT per tier
+    string resctrlGroup;            // resctrl group to run in (created if missing)
+    string catMask;                 // L3 capacity bitmask (hex) for the group
+    int mbaPct = 0;                 // memory-bandwidth throttle for the group (0 = leave)
+    string tkernel;                 // --tkernel: templated kernels to run per tier
+    bool listKernels = false;       // print the templated kernel registry and exit
+    bool stream = false;            // STREAM Copy/Scale/Add/Triad + R:W kernels per tier
+    string rw = "2:1";              // --rw read:write stream ratios
+    vector<pair<int, int>> rwRatios; // parsed --rw
+    bool loaded = false;            // latency under bandwidth load
+    int loadedThreads = 0;          // traffic threads (0 = all other CPUs)
+    string loadedTraffic = "read";  // read | write | copy
+    string loadedDelays = "0,10,20,50,100,200,500,1000,2000,5000,10000";
+    bool numa = false;              // CPU node x memory node matrix
+    size_t numaKB = 0;              // NUMA working set (0 = memKB)
+};
+
+//====================================================
+// Timer backends (--timer)
+//====================================================
+// Kernels time themselves with tnow()/tsec(). The backend is chosen once at
+// startup: TSC (rdtscp + lfence) on x86 with an invariant TSC, the generic
+// timer (cntvct_el0) on AArch64, steady_clock otherwise. Tick rates are
+// calibrated against steady_clock and the back-to-back read cost is subtracted.
+static uint64_t read_chrono()
+{
+    return (uint64_t)chrono::duration_cast<chrono::nanoseconds>(
+        clk::now().time_since_epoch()).count();
+}
+
+#if defined(CB_X86)
+static uint64_t read_tsc()
+{
+    unsigned aux;
+    _mm_lfence();
+    uint64_t t = __rdtscp(&aux);
+    _mm_lfence();
+    return t;
+}
+
+static bool tsc_invariant()
+{
+    unsigned a, b, c, d;
+    if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) return false;
+    __cpuid(0x80000007, a, b, c, d);
+    return (d >> 8) & 1;
+}
+#endif
+
+#if defined(__aarch64__)
+static uint64_t read_cntvct()
+{
+    uint64_t t;
+    asm volatile("isb\n\tmrs %0, cntvct_el0" : "=r"(t) :: "memory");
+    return t;
+}
+#endif
+
+struct Timer
+{
+    const char* name = "chrono";
+    uint64_t (*read)() = read_chrono;
+    double nsPerTick = 1.0;
+    double overheadTicks = 0;       // cost of one back-to-back read pair
+    double cpuGHz = 0;              // estimated core clock (0 = not measured)
 };
 
+static Timer g_timer;
+
+static inline uint64_t tnow()
+{
+    return g_timer.read();
+}
+
+// Seconds between two tnow() reads with the read overhead removed.
+static inline double tsec(uint64_t t0, uint64_t t1)
+{
+    double ticks = (double)(t1 - t0) - g_timer.overheadTicks;
+    return max(ticks, 0.0) * g_timer.nsPerTick * 1e-9;
+}
+
+// Core clock from a chain of dependent 1-cycle adds (16 per iteration, so
+// loop overhead hides under the chain). The addend is a register: recent
+// x86 cores fold add-immediate chains at rename.
+static double estimate_core_ghz()
+{
+#if defined(CB_X86) || defined(__aarch64__)
+    const uint64_t iters = 4000000;
+    uint64_t x = 0, one = 1;
+    auto run = [&]
+    {
+        uint64_t t0 = tnow();
+        for (uint64_t i = 0; i < iters; ++i)
+        {
+#if defined(CB_X86)
+            asm volatile(".rept 16\n\tadd %1, %0\n\t.endr" : "+r"(x) : "r"(one));
+#else
+            asm volatile(".rept 16\n\tadd %0, %0, %1\n\t.endr" : "+r"(x) : "r"(one));
+#endif
+        }
+        return tsec(t0, tnow());
+    };
+    run(); // let the clock ramp up
+    double best = run();
+    for (int r = 0; r < 4; ++r) best = min(best, run());
+    sink64 ^= x;
+    return (double)iters * 16 / best / 1e9;
+#else
+    return 0;
+#endif
+}
+
+// name: auto | chrono | tsc | cntvct. Returns false if unavailable.
+static bool init_timer(const string& name, bool cycles)
+{
+    Timer t;
+    bool want = (name == "auto");
+#if defined(CB_X86)
+    if ((want && tsc_invariant()) || name == "tsc") { t.name = "tsc"; t.read = read_tsc; want = false; }
+#endif
+#if defined(__aarch64__)
+    if (want || name == "cntvct") { t.name = "cntvct"; t.read = read_cntvct; want = false; }
+#endif
+    if (name != "auto" && name != "chrono" && t.read == read_chrono) return false;
+
+    if (t.read != read_chrono)
+    {
+        auto c0 = clk::now();
+        uint64_t k0 = t.read();
+        while (clk::now() - c0 < chrono::milliseconds(20)) {}
+        uint64_t k1 = t.read();
+        double ns = chrono::duration<double, nano>(clk::now() - c0).count();
+        t.nsPerTick = ns / (double)(k1 - k0);
+    }
+
+    double best = 1e30;
+    for (int i = 0; i < 1000; ++i)
+    {
+        uint64_t a = t.read();
+        uint64_t b = t.read();
+        best = min(best, (double)(b - a));
+    }
+    t.overheadTicks = best;
+    g_timer = t;
+
+    if (cycles) g_timer.cpuGHz = estimate_core_ghz();
+    return true;
+}
+
+//====================================================
+// Threads, pinning and barrier
+//====================================================
+static const size_t kLine = 64;     // cache line size assumed for slicing
+
+// CPUs this process may run on, captured once before any thread is pinned.
+static const vector<int>& online_cpus()
+{
+    static const vector<int> cpus = []
+    {
+        vector<int> v;
+#if defined(__linux__)
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) == 0)
+        {
+            for (int c = 0; c < CPU_SETSIZE; ++c)
+                if (CPU_ISSET(c, &set)) v.push_back(c);
+        }
+#endif
+        if (v.empty())
+        {
+            unsigned n = max(1u, thread::hardware_concurrency());
+            for (unsigned c = 0; c < n; ++c) v.push_back((int)c);
+        }
+        return v;
+    }();
+    return cpus;
+}
+
+static void pin_thread(int cpu)
+{
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#elif defined(__APPLE__)
+    // macOS has no hard pinning; an affinity tag keeps threads apart.
+    thread_affinity_policy_data_t pol = { cpu + 1 };
+    thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_AFFINITY_POLICY,
+                      (thread_policy_t)&pol, THREAD_AFFINITY_POLICY_COUNT);
+#else
+    (void)cpu;
+#endif
+}
+
+static inline void cpu_relax()
+{
+#if defined(CB_X86)
+    _mm_pause();
+#elif defined(__aarch64__) || defined(__arm__)
+    asm volatile("yield" ::: "memory");
+#endif
+}
+
+// Sense-reversing spin barrier; yields after a while so oversubscribed runs
+// still make progress.
+struct SpinBarrier
+{
+    explicit SpinBarrier(int n) : count(n) {}
+
+    void wait()
+    {
+        int ph = phase.load(memory_order_acquire);
+        if (waiting.fetch_add(1, memory_order_acq_rel) + 1 == count)
+        {
+            waiting.store(0, memory_order_relaxed);
+            phase.fetch_add(1, memory_order_release);
+            return;
+        }
+        for (unsigned spins = 0; phase.load(memory_order_acquire) == ph; ++spins)
+        {
+            if (spins > 1024) this_thread::yield();
+            else cpu_relax();
+        }
+    }
+
+    int count;
+    atomic<int> waiting{0};
+    atomic<int> phase{0};
+};
+
+//====================================================
+// Cache hierarchy detection
+//====================================================
+struct CacheLevel
+{
+    size_t bytes = 0;               // capacity of one instance
+    int ways = 0;                   // associativity (0 = unknown)
+    size_t line = 64;               // line size in bytes
+};
+
+struct CacheInfo
+{
+    CacheLevel l1, l2, l3;          // L1 is the data cache
+    string source = "defaults";     // where the numbers came from
+};
+
+#if defined(__linux__)
+static string read_text(const string& path)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return "";
+    char buf[256];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = 0;
+    string s(buf);
+    while (!s.empty() && (s.back() == '\n' || s.back() == ' ')) s.pop_back();
+    return s;
+}
+
+// Parses sysfs sizes such as "48K" or "32M".
+static size_t parse_size(const string& s)
+{
+    if (s.empty()) return 0;
+    size_t v = strtoull(s.c_str(), nullptr, 10);
+    switch (s.back())
+    {
+        case 'K': return v << 10;
+        case 'M': return v << 20;
+        case 'G': return v << 30;
+        default:  return v;
+    }
+}
+
+static bool caches_from_sysfs(CacheInfo& c)
+{
+    string base = "/sys/devices/system/cpu/cpu" + to_string(online_cpus()[0]) + "/cache/index";
+    bool any = false;
+    for (int idx = 0; idx < 16; ++idx)
+    {
+        string dir = base + to_string(idx) + "/";
+        string level = read_text(dir + "level");
+        if (level.empty()) break;
+        if (read_text(dir + "type") == "Instruction") continue;
+
+        CacheLevel L;
+        L.bytes = parse_size(read_text(dir + "size"));
+        L.ways = atoi(read_text(dir + "ways_of_associativity").c_str());
+        size_t line = strtoull(read_text(dir + "coherency_line_size").c_str(), nullptr, 10);
+        if (line) L.line = line;
+        if (!L.bytes) continue;
+
+        if (level == "1") c.l1 = L;
+        else if (level == "2") c.l2 = L;
+        else if (level == "3") c.l3 = L;
+        any = true;
+    }
+    if (any) c.source = "sysfs";
+    return any;
+}
+#endif
+
+#if defined(__APPLE__)
+static size_t sysctl_size(const char* name)
+{
+    uint64_t v = 0;
+    size_t len = sizeof(v);
+    if (sysctlbyname(name, &v, &len, nullptr, 0) != 0) return 0;
+    return len == sizeof(uint32_t) ? (size_t)(uint32_t)v : (size_t)v;
+}
+
+static bool caches_from_sysctl(CacheInfo& c)
+{
+    // Hybrid parts report per-cluster values; perflevel0 is the P-cluster.
+    c.l1.bytes = sysctl_size("hw.perflevel0.l1dcachesize");
+    c.l2.bytes = sysctl_size("hw.perflevel0.l2cachesize");
+    if (!c.l1.bytes) c.l1.bytes = sysctl_size("hw.l1dcachesize");
+    if (!c.l2.bytes) c.l2.bytes = sysctl_size("hw.l2cachesize");
+    c.l3.bytes = sysctl_size("hw.l3cachesize");
+    size_t line = sysctl_size("hw.cachelinesize");
+    if (line) c.l1.line = c.l2.line = c.l3.line = line;
+    if (!c.l1.bytes && !c.l2.bytes) return false;
+    c.source = "sysctl";
+    return true;
+}
+#endif
+
+#if defined(CB_X86)
+// CPUID leaf 4 (Intel) / 0x8000001D (AMD): deterministic cache parameters.
+static bool caches_from_cpuid(CacheInfo& c)
+{
+    unsigned a, b, cx, d;
+    unsigned leaf = 4;
+    if (!__get_cpuid(0, &a, &b, &cx, &d)) return false;
+    bool amd = (b == 0x68747541); // "Auth"enticAMD
+    if (amd)
+    {
+        leaf = 0x8000001D;
+        if (__get_cpuid_max(0x80000000, nullptr) < leaf) return false;
+    }
+    else if (a < 4) return false;
+
+    bool any = false;
+    for (unsigned sub = 0; sub < 16; ++sub)
+    {
+        __cpuid_count(leaf, sub, a, b, cx, d);
+        unsigned type = a & 0x1F;       // 0 = no more caches, 2 = instruction
+        if (type == 0) break;
+        if (type == 2) continue;
+        unsigned level = (a >> 5) & 0x7;
+        CacheLevel L;
+        L.ways = (int)((b >> 22) & 0x3FF) + 1;
+        size_t parts = ((b >> 12) & 0x3FF) + 1;
+        L.line = (b & 0xFFF) + 1;
+        size_t sets = (size_t)cx + 1;
+        L.bytes = (size_t)L.ways * parts * L.line * sets;
+        if (level == 1) c.l1 = L;
+        else if (level == 2) c.l2 = L;
+        else if (level == 3) c.l3 = L;
+        any = true;
+    }
+    if (any) c.source = "cpuid";
+    return any;
+}
+#endif
+
+// Detected once; sysfs/sysctl first, CPUID as the fallback.
+static const CacheInfo& cache_info()
+{
+    static const CacheInfo info = []
+    {
+        CacheInfo c;
+        bool ok = false;
+#if defined(__linux__)
+        ok = caches_from_sysfs(c);
+#elif defined(__APPLE__)
+        ok = caches_from_sysctl(c);
+#endif
+#if defined(CB_X86)
+        if (!ok) ok = caches_from_cpuid(c);
+#endif
+        (void)ok;
+        return c;
+    }();
+    return info;
+}
+
+// Fills tier sizes the user did not pass: each cache tier uses half of its
+// level (and at least twice the level below, so it cannot fit there),
+// Memory uses 4x the last-level cache. Unknown levels keep the old defaults.
+static void apply_cache_defaults(size_t& l1KB, size_t& l2KB, size_t& l3KB, size_t& memKB)
+{
+    const CacheInfo& c = cache_info();
+    size_t c1 = c.l1.bytes ? c.l1.bytes >> 10 : 32 * 2;
+    size_t c2 = c.l2.bytes ? c.l2.bytes >> 10 : 512 * 2;
+    size_t c3 = c.l3.bytes ? c.l3.bytes >> 10 : max<size_t>(8192 * 2, c2 * 4);
+
+    auto tier = [](size_t cap, size_t below)
+    {
+        size_t kb = cap / 2;
+        if (kb < below * 2) kb = (cap + below) / 2;
+        return max<size_t>(kb, 4);
+    };
+
+    if (!l1KB) l1KB = max<size_t>(c1 / 2, 4);
+    if (!l2KB) l2KB = tier(c2, c1);
+    if (!l3KB) l3KB = tier(c3, c2);
+    if (!memKB) memKB = max<size_t>(131072, c3 * 4);
+}
+
 //====================================================
 // Helper functions
 //====================================================
 static void usage(const char* prog) 
 {
     cerr << "Usage: " << prog
-              << " [--iters N] [--stride B] [--l1KB N] [--l2KB N] [--l3KB N] "
-                 "[--memKB N] [--quick]\n";
+              << " [--iters N] [--target-ms T] [--ci PCT] [--stats] [--stride B]\n"
+                 "       [--l1KB N] [--l2KB N] [--l3KB N] "
+                 "[--memKB N] [--threads N|all] "
+                 "[--kernel auto|scalar|sse|avx2|avx512|neon] [--quick]\n"
+                 "       [--sweep [--sweep-minKB N] [--sweep-maxKB N] [--ppo N]]\n"
+                 "       [--mlp [--mlp-max K] [--mlpKB N]] [--pages 4k|thp|2m|1g]\n"
+                 "       [--numa [--numaKB N]] [--timer auto|chrono|tsc|cntvct] [--cycles] [--counters]\n"
+                 "       [--format text|json|csv] [--compare baseline.json [--tolerance PCT]]\n"
+                 "       [--loaded [--loaded-threads N] [--loaded-traffic read|write|copy]\n"
+                 "                 [--loaded-delays D1,D2,...]]\n"
+                 "       [--patterns [--pattern-stride B]]\n"
+                 "       [--prefetch [--prefetchKB N] [--prefetch-dists D1,D2,...]]\n"
+                 "       [--c2c [--c2c-cpus LIST] [--c2c-padding B1,B2,...]]\n"
+                 "       [--atomics] [--io FILE [--ioMB N]] [--faults [--faultMB N]]\n"
+                 "       [--alloc [--alloc-ops N]]\n"
+                 "       [--layout [--layout-fields N] [--layout-field-bytes B] [--layout-block L]]\n"
+                 "       [--structs] [--copy [--copy-maxKB N] [--copy-align-size B]\n"
+                 "                          [--copy-misalign LIST]]\n"
+                 "       [--stream [--rw R:W,...]] [--tlb [--tlb-pages N] [--tlb-huge-pages N]]\n"
+                 "       [--assoc [--assoc-max-stride B] [--assoc-max-n N]]\n"
+                 "       [--monitor [--monitor-interval S] [--monitor-count N] [--monitor-budget PCT]\n"
+                 "                  [--monitor-nice N] [--monitor-format jsonl|prom] [--monitor-out FILE]\n"
+                 "                  [--monitorKB N]]\n"
+                 "       [--tkernel NAME,...|PREFIX*|all] [--list-kernels]\n"
+                 "       [--rdt] [--resctrl GROUP] [--cat-mask HEX] [--mba PCT]\n"
+                 "       [--only LIST] [--skip LIST] [--all] [--time-budget SEC] [--pipeline]\n"
+                 "       suites: tiers sweep mlp numa patterns copy structs layout alloc faults assoc\n"
+                 "               tlb io atomics c2c prefetch tkernel loaded\n";
 }
 
 static bool parse(int argc, char** argv, Args& a)
@@ -73,12 +806,102 @@ static bool parse(int argc, char** argv, Args& a)
         };
 
         if (s == "--iters") { if (!need(1)) return false; a.iters = stoi(argv[++i]); }
+        else if (s == "--target-ms") { if (!need(1)) return false; a.targetMs = stod(argv[++i]); }
+        else if (s == "--ci") { if (!need(1)) return false; a.ciPct = stod(argv[++i]); }
+        else if (s == "--stats") { a.stats = true; }
         else if (s == "--stride") { if (!need(1)) return false; a.stride = stoull(argv[++i]); }
         else if (s == "--l1KB") { if (!need(1)) return false; a.l1KB = stoull(argv[++i]); }
         else if (s == "--l2KB") { if (!need(1)) return false; a.l2KB = stoull(argv[++i]); }
         else if (s == "--l3KB") { if (!need(1)) return false; a.l3KB = stoull(argv[++i]); }
         else if (s == "--memKB") { if (!need(1)) return false; a.memKB = stoull(argv[++i]); }
+        else if (s == "--threads")
+        {
+            if (!need(1)) return false;
+            string v(argv[++i]);
+            a.threads = (v == "all") ? 0 : stoi(v);
+        }
+        else if (s == "--kernel") { if (!need(1)) return false; a.kernel = argv[++i]; }
         else if (s == "--quick") { a.quick = true; }
+        else if (s == "--sweep") { a.sweep = true; }
+        else if (s == "--sweep-minKB") { if (!need(1)) return false; a.sweepMinKB = stoull(argv[++i]); }
+        else if (s == "--sweep-maxKB") { if (!need(1)) return false; a.sweepMaxKB = stoull(argv[++i]); }
+        else if (s == "--ppo") { if (!need(1)) return false; a.ppo = stoi(argv[++i]); }
+        else if (s == "--mlp") { a.mlp = true; }
+        else if (s == "--mlp-max") { if (!need(1)) return false; a.mlpMax = stoi(argv[++i]); }
+        else if (s == "--mlpKB") { if (!need(1)) return false; a.mlpKB = stoull(argv[++i]); }
+        else if (s == "--timer") { if (!need(1)) return false; a.timer = argv[++i]; }
+        else if (s == "--cycles") { a.cycles = true; }
+        else if (s == "--counters") { a.counters = true; }
+        else if (s == "--c2c") { a.c2c = true; }
+        else if (s == "--atomics") { a.atomics = true; }
+        else if (s == "--stream") { a.stream = true; }
+        else if (s == "--tlb") { a.tlb = true; }
+        else if (s == "--only") { if (!need(1)) return false; a.only = argv[++i]; }
+        else if (s == "--skip") { if (!need(1)) return false; a.skip = argv[++i]; }
+        else if (s == "--all") { a.all = true; }
+        else if (s == "--time-budget") { if (!need(1)) return false; a.timeBudgetSec = stod(argv[++i]); }
+        else if (s == "--pipeline") { a.pipeline = true; }
+        else if (s == "--rdt") { a.rdt = true; }
+        else if (s == "--resctrl") { if (!need(1)) return false; a.resctrlGroup = argv[++i]; a.rdt = true; }
+        else if (s == "--cat-mask") { if (!need(1)) return false; a.catMask = argv[++i]; a.rdt = true; }
+        else if (s == "--mba") { if (!need(1)) return false; a.mbaPct = stoi(argv[++i]); a.rdt = true; }
+        else if (s == "--tkernel") { if (!need(1)) return false; a.tkernel = argv[++i]; }
+        else if (s == "--list-kernels") { a.listKernels = true; }
+        else if (s == "--monitor") { a.monitor = true; }
+        else if (s == "--monitor-interval") { if (!need(1)) return false; a.monitorInterval = stod(argv[++i]); }
+        else if (s == "--monitor-count") { if (!need(1)) return false; a.monitorCount = stoull(argv[++i]); }
+        else if (s == "--monitor-budget") { if (!need(1)) return false; a.monitorBudgetPct = stod(argv[++i]); }
+        else if (s == "--monitor-nice") { if (!need(1)) return false; a.monitorNice = stoi(argv[++i]); }
+        else if (s == "--monitor-format") { if (!need(1)) return false; a.monitorFormat = argv[++i]; }
+        else if (s == "--monitor-out") { if (!need(1)) return false; a.monitorOut = argv[++i]; }
+        else if (s == "--monitorKB") { if (!need(1)) return false; a.monitorKB = stoull(argv[++i]); }
+        else if (s == "--assoc") { a.assoc = true; }
+        else if (s == "--assoc-max-stride") { if (!need(1)) return false; a.assocMaxStride = stoull(argv[++i]); }
+        else if (s == "--assoc-max-n") { if (!need(1)) return false; a.assocMaxN = stoi(argv[++i]); }
+        else if (s == "--tlb-pages") { if (!need(1)) return false; a.tlbPages = stoull(argv[++i]); }
+        else if (s == "--tlb-huge-pages") { if (!need(1)) return false; a.tlbHugePages = stoull(argv[++i]); }
+        else if (s == "--rw") { if (!need(1)) return false; a.rw = argv[++i]; }
+        else if (s == "--copy") { a.copy = true; }
+        else if (s == "--copy-maxKB") { if (!need(1)) return false; a.copyMaxKB = stoull(argv[++i]); }
+        else if (s == "--copy-align-size") { if (!need(1)) return false; a.copyAlignSize = stoull(argv[++i]); }
+        else if (s == "--copy-misalign") { if (!need(1)) return false; a.copyMisalign = argv[++i]; }
+        else if (s == "--structs") { a.structs = true; }
+        else if (s == "--layout") { a.layout = true; }
+        else if (s == "--layout-fields") { if (!need(1)) return false; a.layoutFields = stoull(argv[++i]); }
+        else if (s == "--layout-field-bytes") { if (!need(1)) return false; a.layoutFieldBytes = stoull(argv[++i]); }
+        else if (s == "--layout-block") { if (!need(1)) return false; a.layoutBlock = stoull(argv[++i]); }
+        else if (s == "--alloc") { a.alloc = true; }
+        else if (s == "--alloc-ops") { if (!need(1)) return false; a.allocOps = stoull(argv[++i]); }
+        else if (s == "--faults") { a.faults = true; }
+        else if (s == "--faultMB") { if (!need(1)) return false; a.faultMB = stoull(argv[++i]); }
+        else if (s == "--io") { if (!need(1)) return false; a.ioPath = argv[++i]; }
+        else if (s == "--ioMB") { if (!need(1)) return false; a.ioMB = stoull(argv[++i]); }
+        else if (s == "--c2c-cpus") { if (!need(1)) return false; a.c2cCpus = argv[++i]; }
+        else if (s == "--c2c-padding") { if (!need(1)) return false; a.c2cPadding = argv[++i]; }
+        else if (s == "--format") { if (!need(1)) return false; a.format = argv[++i]; }
+        else if (s == "--compare") { if (!need(1)) return false; a.compare = argv[++i]; }
+        else if (s == "--tolerance") { if (!need(1)) return false; a.tolerancePct = stod(argv[++i]); }
+        else if (s == "--patterns") { a.patterns = true; }
+        else if (s == "--pattern-stride") { if (!need(1)) return false; a.patternStride = stoull(argv[++i]); }
+        else if (s == "--prefetch") { a.prefetch = true; }
+        else if (s == "--prefetchKB") { if (!need(1)) return false; a.prefetchKB = stoull(argv[++i]); }
+        else if (s == "--prefetch-dists") { if (!need(1)) return false; a.prefetchDists = argv[++i]; }
+        else if (s == "--loaded") { a.loaded = true; }
+        else if (s == "--loaded-threads") { if (!need(1)) return false; a.loadedThreads = stoi(argv[++i]); }
+        else if (s == "--loaded-traffic") { if (!need(1)) return false; a.loadedTraffic = argv[++i]; }
+        else if (s == "--loaded-delays") { if (!need(1)) return false; a.loadedDelays = argv[++i]; }
+        else if (s == "--numa") { a.numa = true; }
+        else if (s == "--numaKB") { if (!need(1)) return false; a.numaKB = stoull(argv[++i]); }
+        else if (s == "--pages")
+        {
+            if (!need(1)) return false;
+            if (!parse_page_kind(argv[++i], a.pages))
+            {
+                cerr << "Unknown page size: " << argv[i] << "\n";
+                usage(argv[0]);
+                return false;
+            }
+        }
         else if (s == "-h" || s == "--help") { usage(argv[0]); return false; }
         else 
         {
@@ -88,213 +911,5825 @@ static bool parse(int argc, char** argv, Args& a)
         }
     }
 
+    if (a.format != "text" && a.format != "json" && a.format != "csv")
+    {
+        cerr << "Unknown format: " << a.format << "\n";
+        usage(argv[0]);
+        return false;
+    }
+    if (a.monitorFormat != "jsonl" && a.monitorFormat != "prom")
+    {
+        cerr << "Unknown --monitor-format: " << a.monitorFormat << "\n";
+        return false;
+    }
+    if (a.monitorFormat == "prom" && a.monitorOut.empty())
+    {
+        cerr << "--monitor-format prom needs --monitor-out FILE\n";
+        return false;
+    }
+    if (a.monitorInterval <= 0)
+    {
+        cerr << "--monitor-interval must be positive\n";
+        return false;
+    }
+    if (a.loadedTraffic != "read" && a.loadedTraffic != "write" && a.loadedTraffic != "copy")
+    {
+        cerr << "Unknown --loaded-traffic: " << a.loadedTraffic << "\n";
+        return false;
+    }
+    for (size_t i = 0; i < a.rw.size();)
+    {
+        size_t end = a.rw.find(',', i);
+        if (end == string::npos) end = a.rw.size();
+        string part = a.rw.substr(i, end - i);
+        size_t colon = part.find(':');
+        int r = atoi(part.c_str());
+        int w = (colon == string::npos) ? 0 : atoi(part.c_str() + colon + 1);
+        if (r < 1 || w < 1 || r > 4 || w > 4)
+        {
+            cerr << "Bad --rw ratio '" << part << "' (want R:W with R, W in 1..4)\n";
+            return false;
+        }
+        a.rwRatios.push_back({ r, w });
+        i = end + 1;
+    }
+    if (a.threads < 0)
+    {
+        cerr << "--threads must be a positive count or 'all'\n";
+        return false;
+    }
+    if (a.threads == 0) a.threads = (int)online_cpus().size();
+    if (a.ppo < 1) a.ppo = 1;
+    a.patternStride = max<size_t>(sizeof(uint64_t), a.patternStride & ~(sizeof(uint64_t) - 1));
+    a.layoutFields = max<size_t>(1, a.layoutFields);
+    a.layoutFieldBytes = max<size_t>(4, a.layoutFieldBytes & ~(size_t)3);
+    {
+        size_t b = 1;
+        while (b < a.layoutBlock) b *= 2;
+        a.layoutBlock = b;
+    }
+    {
+        size_t b = 1024;
+        while (b < a.assocMaxStride) b *= 2;
+        a.assocMaxStride = b;
+    }
+    if (a.sweepMinKB == 0) a.sweepMinKB = 1;
+
     if (a.stride == 0) a.stride = sizeof(void*);
     if (a.stride % sizeof(void*) != 0) 
     {
         a.stride = ((a.stride + sizeof(void*) - 1) / sizeof(void*)) * sizeof(void*);
     }
+    apply_cache_defaults(a.l1KB, a.l2KB, a.l3KB, a.memKB);
+    if (a.targetMs <= 0) a.targetMs = a.quick ? 20 : 100;
     if (a.quick) 
     {
         a.iters = 2;
-        a.memKB = min<size_t>(a.memKB, 65536); // 64 MB in quick mode
+        // 64 MB in quick mode, unless that would still fit in L3
+        a.memKB = min<size_t>(a.memKB, max<size_t>(65536, 2 * (cache_info().l3.bytes >> 10)));
     }
+    if (!a.sweepMaxKB) a.sweepMaxKB = a.memKB;
+    if (!a.mlpKB) a.mlpKB = a.memKB;
+    if (!a.numaKB) a.numaKB = a.memKB;
+    if (!a.prefetchKB) a.prefetchKB = a.memKB;
+    if (!a.copyMaxKB) a.copyMaxKB = a.memKB;
+    if (!a.monitorKB) a.monitorKB = a.memKB;
+    if (!a.tlbPages) a.tlbPages = a.quick ? 8192 : 32768;
+    if (!a.tlbHugePages) a.tlbHugePages = a.quick ? 128 : 512;
+    a.copyAlignSize = max<size_t>(1, a.copyAlignSize);
+    a.sweepMaxKB = max(a.sweepMaxKB, a.sweepMinKB);
 
     return true;
 }
 
 //====================================================
-// Benchmark functions (read/write/copy/latency)
+// Measurement engine (adaptive repetitions)
 //====================================================
-static double bw_read_gbs(char* buf, size_t bytes, int iters) 
+// Every metric is sampled until its 95% confidence interval is within
+// --ci of the mean, or the --target-ms budget is spent; the first --iters
+// samples are always taken. Summaries are in metric units, ordered by time:
+// `min` is the fastest sample, `p95` the slow tail.
+struct Stats
 {
-    size_t els = bytes / sizeof(double);
-    auto* p = reinterpret_cast<double*>(buf);
-
-    // warmup
-    double warm = 0;
-    for (size_t i = 0; i < els; i += 64 / sizeof(double)) warm += p[i];
-    sink64 ^= (uint64_t)warm;
-
-    double t = 0;
-    for (int r = 0; r < iters; ++r) 
-    {
-        auto t0 = clk::now();
-        double sum = 0;
-        for (size_t i = 0; i < els; ++i) sum += p[i];
-        auto t1 = clk::now();
-        t += chrono::duration<double>(t1 - t0).count();
-        sink64 ^= (uint64_t)sum;
-    }
-    t /= iters;
-    return bytes / t / 1e9;
-}
+    double value = 0;               // reported number (median)
+    double min = 0;
+    double median = 0;
+    double p95 = 0;
+    double stddev = 0;
+    int n = 0;
+    bool unstable = false;          // CV above kUnstableCV
+};
 
-static double bw_write_gbs(char* buf, size_t bytes, int iters) 
+struct Adaptive
 {
-    size_t els = bytes / sizeof(double);
-    auto* p = reinterpret_cast<double*>(buf);
-
-    // warmup
-    for (size_t i = 0; i < els; i += 64 / sizeof(double)) p[i] = (double)i;
+    double targetSec = 0.1;         // time budget per metric
+    double ci = 0.01;               // wanted relative CI half-width
+    int maxReps = 10000;
+};
 
-    double t = 0;
-    for (int r = 0; r < iters; ++r) 
-    {
-        auto t0 = clk::now();
-        for (size_t i = 0; i < els; ++i) p[i] = (double)i;
-        auto t1 = clk::now();
-        t += chrono::duration<double>(t1 - t0).count();
-    }
-    t /= iters;
-    return bytes / t / 1e9;
-}
+static Adaptive g_adapt;
+static const double kUnstableCV = 0.05;
 
-static double bw_copy_gbs(char* dst, char* src, size_t bytes, int iters) 
+class RepLoop
 {
-    memcpy(dst, src, bytes); // warmup
-    double t = 0;
+public:
+    explicit RepLoop(int minReps) : minReps_(max(1, minReps)) {}
 
-    for (int r = 0; r < iters; ++r) 
+    // Records one sample (seconds); returns true when enough were taken.
+    bool add(double sec)
     {
-        auto t0 = clk::now();
-        memcpy(dst, src, bytes);
-        auto t1 = clk::now();
-        t += chrono::duration<double>(t1 - t0).count();
+        secs_.push_back(sec);
+        spent_ += sec;
+        int n = (int)secs_.size();
+        if (n < minReps_) return false;
+        if (n >= g_adapt.maxReps || spent_ >= g_adapt.targetSec) return true;
+        if (n < 3) return false;
+        double mean = 0, var = 0;
+        for (double s : secs_) mean += s;
+        mean /= n;
+        for (double s : secs_) var += (s - mean) * (s - mean);
+        double half = 1.96 * sqrt(var / (n - 1)) / sqrt((double)n);
+        return half <= g_adapt.ci * mean;
     }
-    t /= iters;
-    return bytes / t / 1e9;
-}
-
-static double latency_ns(char* buf, size_t bytes, size_t stride) 
-{
-    size_t nodes = max<size_t>(2, bytes / stride);
-    vector<size_t> idx(nodes);
-    for (size_t i = 0; i < nodes; ++i) idx[i] = i;
 
-    mt19937_64 rng(1234567);
-    shuffle(idx.begin(), idx.end(), rng);
+    const vector<double>& samples() const { return secs_; }
 
-    for (size_t i = 0; i + 1 < nodes; ++i) 
+    // Converts each sample with toValue (e.g. seconds -> GB/s) and summarises.
+    template <typename F>
+    Stats stats(F toValue) const
     {
-        auto slot = reinterpret_cast<char**>(buf + idx[i] * stride);
-        *slot = (buf + idx[i + 1] * stride);
+        Stats s;
+        vector<double> t = secs_;
+        sort(t.begin(), t.end());
+        s.n = (int)t.size();
+        if (!s.n) return s;
+        auto pct = [&](double q) { return t[min<size_t>(t.size() - 1, (size_t)(q * (t.size() - 1) + 0.5))]; };
+        s.min = toValue(t.front());
+        s.median = s.value = toValue(pct(0.5));
+        s.p95 = toValue(pct(0.95));
+        double mean = 0, var = 0;
+        for (double x : t) mean += toValue(x);
+        mean /= s.n;
+        for (double x : t) var += (toValue(x) - mean) * (toValue(x) - mean);
+        s.stddev = s.n > 1 ? sqrt(var / (s.n - 1)) : 0;
+        s.unstable = mean > 0 && s.stddev / mean > kUnstableCV;
+        return s;
     }
-    *reinterpret_cast<char**>(buf + idx.back() * stride) = (buf + idx[0] * stride);
 
-    volatile char** p = reinterpret_cast<volatile char**>(buf + idx[0] * stride);
-
-    // warmup
-    for (size_t i = 0; i < 2000; ++i) 
-    {
-        p = (volatile char**)(*p);
-    }
+private:
+    int minReps_;
+    double spent_ = 0;
+    vector<double> secs_;
+};
 
-    // derefs
-    uint64_t derefs = min<uint64_t>(150000, max<uint64_t>(40000, nodes * 8));
-    auto t0 = clk::now();
-    for (uint64_t i = 0; i < derefs; ++i) 
+// Times body() (one pass, returns a value for sink64) through a RepLoop
+// after one untimed warmup call.
+template <typename F>
+static RepLoop run_reps(F body, int iters)
+{
+    RepLoop loop(iters);
+    sink64 ^= (uint64_t)body();
+    bool done = false;
+    while (!done)
     {
-        p = (volatile char**)(*p);
+        uint64_t t0 = tnow();
+        double v = body();
+        uint64_t t1 = tnow();
+        done = loop.add(tsec(t0, t1));
+        sink64 ^= (uint64_t)v;
     }
-    auto t1 = clk::now();
-
-    sink64 ^= (uint64_t)(uintptr_t)p;
-    double ns = chrono::duration<double>(t1 - t0).count() * 1e9;
-    return ns / (double)derefs;
+    return loop;
 }
 
 //====================================================
-// Result row
+// Metric registry (--format / --compare)
 //====================================================
-struct Row 
+// Every suite records each number it prints under a stable dotted key, e.g.
+// "L2.read_gbs". The registry feeds JSON/CSV output and baseline diffs.
+struct Metric
 {
-    double 
-    r, 
-    w, 
-    c, 
-    l;
+    string key;
+    double value;
+    string unit;
+    bool higherIsBetter;
+    double cvPct;                   // sample CV in % (0 = single sample)
 };
 
-static Row benchTier(const char* name,
-                     size_t KB,
-                     char* b1,
-                     char* b2,
-                     int iters,
-                     size_t stride) 
+static vector<Metric> g_metrics;
+
+static void record(const string& key, double value, const char* unit, bool higherIsBetter,
+                   double cvPct = 0)
 {
-    size_t bytes = KB * 1024ULL;
-    Row x;
-    x.r = bw_read_gbs(b1, bytes, iters);
-    x.w = bw_write_gbs(b1, bytes, iters);
-    x.c = bw_copy_gbs(b2, b1, bytes, iters);
-    x.l = latency_ns(b1, bytes, stride);
-    (void)name;
-    return x;
+    g_metrics.push_back({ key, value, unit, higherIsBetter, cvPct });
 }
 
-static void printRow(const char* label, const Row& x) 
+static void record(const string& key, const Stats& s, const char* unit, bool higherIsBetter)
 {
-    auto fmt = [&](double v) 
-    {
-        bool gb = v >= 1000.0;
-        double vv = gb ? v : v * 1000.0;
-        const char* u = gb ? "GB/s" : "MB/s";
-        cout << setw(8) << fixed << setprecision(2) << vv << " " << u;
-    };
-
-    cout << left << setw(8) << label
-              << "  Read ";  fmt(x.r);
-    cout << "   Write "; fmt(x.w);
-    cout << "   Copy ";  fmt(x.c);
-    cout << "   Latency " << setw(6)
-              << fixed << setprecision(2) << x.l << " ns\n";
+    double mean = s.median != 0 ? s.median : 1;
+    record(key, s.value, unit, higherIsBetter, s.n > 1 ? 100.0 * s.stddev / fabs(mean) : 0);
 }
 
 //====================================================
-// Main
+// Hardware performance counters (--counters)
 //====================================================
-int main(int argc, char** argv) 
+// Optional counts around each timed region of benchTier: cycles,
+// instructions, L1D read misses, L2 misses (approximated by LLC references,
+// which is what the generic perf event maps to on Intel and AMD), LLC read
+// misses, DTLB read misses, and DRAM bytes from the uncore memory controller
+// (Intel uncore_imc CAS counts; system-wide, so it needs perf_event_paranoid
+// <= 0 or CAP_PERFMON). Counters are free-running; a region is the delta of
+// two reads, scaled for multiplexing, and normalised by g_accesses: 64 B
+// lines processed by the bandwidth passes or derefs by the latency chase.
+// macOS kperf is a private framework and is not wired up; the suite reports
+// the counters as unavailable there.
+enum Pmc { PmcCycles, PmcInstr, PmcL1dMiss, PmcL2Miss, PmcLlcMiss, PmcDtlbMiss, PmcDramBytes,
+           kNumPmc };
+static const char* const kPmcNames[kNumPmc] = {
+    "cycles", "instructions", "l1d_miss", "l2_miss", "llc_miss", "dtlb_miss", "dram_bytes" };
+
+// Work done by the timed kernels (see above); bumped by bw_gbs and chase_latency.
+static atomic<uint64_t> g_accesses{0};
+
+struct PmcCounts
+{
+    bool valid = false;
+    bool have[kNumPmc] = {};
+    double v[kNumPmc] = {};         // per access
+};
+
+#if defined(__linux__)
+struct PmcFd
+{
+    int fd;
+    double scale;                   // count -> unit (dram_bytes: bytes per count)
+};
+
+static vector<PmcFd> g_pmcFds[kNumPmc];
+
+static int perf_open(perf_event_attr& attr, pid_t pid, int cpu)
+{
+    attr.size = sizeof(attr);
+    attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return (int)syscall(SYS_perf_event_open, &attr, pid, cpu, -1, 0);
+}
+
+// Counts this process and every thread it spawns afterwards (inherit), in
+// user and kernel mode where permitted.
+static int open_task_event(uint32_t type, uint64_t config)
+{
+    perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.type = type;
+    attr.config = config;
+    attr.inherit = 1;
+    int fd = perf_open(attr, 0, -1);
+    if (fd < 0)
+    {
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = perf_open(attr, 0, -1);
+    }
+    return fd;
+}
+
+static uint64_t cache_event(uint64_t cache, uint64_t op, uint64_t result)
+{
+    return cache | (op << 8) | (result << 16);
+}
+
+// Encodes a sysfs event string such as "event=0x04,umask=0x03" using the
+// PMU's format/ files ("config:0-7").
+static bool sysfs_event_config(const string& pmu, const string& spec, uint64_t& config)
+{
+    config = 0;
+    size_t pos = 0;
+    while (pos < spec.size())
+    {
+        size_t end = spec.find(',', pos);
+        if (end == string::npos) end = spec.size();
+        string term = spec.substr(pos, end - pos);
+        pos = end + 1;
+        size_t eq = term.find('=');
+        string field = term.substr(0, eq);
+        uint64_t value = eq == string::npos ? 1 : strtoull(term.c_str() + eq + 1, nullptr, 0);
+
+        string fmt = read_text(pmu + "/format/" + field);
+        unsigned lo = 0, hi = 0;
+        int n = sscanf(fmt.c_str(), "config:%u-%u", &lo, &hi);
+        if (n < 1) return false;                 // config1/config2 fields are not needed here
+        config |= value << lo;
+    }
+    return true;
+}
+
+static void open_imc_events()
+{
+    for (int dev = 0; dev < 64; ++dev)
+    {
+        string pmu = "/sys/bus/event_source/devices/uncore_imc_" + to_string(dev);
+        string type = read_text(pmu + "/type");
+        if (type.empty()) continue;
+        int cpu = atoi(read_text(pmu + "/cpumask").c_str());
+        for (const char* ev : { "cas_count_read", "cas_count_write" })
+        {
+            uint64_t config;
+            string spec = read_text(pmu + "/events/" + ev);
+            if (spec.empty() || !sysfs_event_config(pmu, spec, config)) continue;
+            double scale = atof(read_text(pmu + "/events/" + ev + ".scale").c_str());
+            string unit = read_text(pmu + "/events/" + ev + ".unit");
+            if (scale <= 0) scale = 64.0, unit = "";       // one CAS = one line
+            if (unit.find("MiB") != string::npos) scale *= 1048576.0;
+
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.type = (uint32_t)atoi(type.c_str());
+            attr.config = config;
+            int fd = perf_open(attr, -1, cpu);
+            if (fd >= 0) g_pmcFds[PmcDramBytes].push_back({ fd, scale });
+        }
+    }
+}
+
+// Opens whatever subset of the events this kernel/CPU/permission level
+// allows; returns false when none could be opened.
+static bool pmc_open(string& detail)
+{
+    struct { Pmc id; uint32_t type; uint64_t config; } core[] = {
+        { PmcCycles,   PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PmcInstr,    PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PmcL1dMiss,  PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_L1D,
+                       PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        { PmcL2Miss,   PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+        { PmcLlcMiss,  PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_LL,
+                       PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+        { PmcDtlbMiss, PERF_TYPE_HW_CACHE, cache_event(PERF_COUNT_HW_CACHE_DTLB,
+                       PERF_COUNT_HW_CACHE_OP_READ, PERF_COUNT_HW_CACHE_RESULT_MISS) },
+    };
+    for (const auto& e : core)
+    {
+        int fd = open_task_event(e.type, e.config);
+        if (fd >= 0) g_pmcFds[e.id].push_back({ fd, 1.0 });
+    }
+    open_imc_events();
+
+    int opened = 0;
+    for (int i = 0; i < kNumPmc; ++i)
+    {
+        if (g_pmcFds[i].empty()) continue;
+        detail += (opened++ ? " " : "") + string(kPmcNames[i]);
+    }
+    if (!opened)
+    {
+        string paranoid = read_text("/proc/sys/kernel/perf_event_paranoid");
+        detail = "no events could be opened (no PMU exposed, or perf_event_paranoid=" +
+                 (paranoid.empty() ? string("?") : paranoid) + ")";
+    }
+    return opened > 0;
+}
+
+// Multiplex-scaled running totals of every open event.
+static void pmc_read(double out[kNumPmc])
+{
+    for (int i = 0; i < kNumPmc; ++i)
+    {
+        out[i] = 0;
+        for (const PmcFd& f : g_pmcFds[i])
+        {
+            uint64_t v[3] = {};
+            if (read(f.fd, v, sizeof(v)) != (ssize_t)sizeof(v) || v[2] == 0) continue;
+            out[i] += (double)v[0] * ((double)v[1] / (double)v[2]) * f.scale;
+        }
+    }
+}
+#else
+static bool pmc_open(string& detail)
+{
+    detail = "not supported on this OS (macOS kperf is not wired up)";
+    return false;
+}
+
+static void pmc_read(double out[kNumPmc])
+{
+    for (int i = 0; i < kNumPmc; ++i) out[i] = 0;
+}
+#endif
+
+static bool g_pmcOn = false;
+
+// Runs fn() and returns the counter deltas per access (invalid when counters
+// are off or fn did no counted work).
+template <typename F>
+static PmcCounts counted(F fn)
+{
+    PmcCounts c;
+    if (!g_pmcOn)
+    {
+        fn();
+        return c;
+    }
+    double a[kNumPmc], b[kNumPmc];
+    uint64_t w0 = g_accesses.load();
+    pmc_read(a);
+    fn();
+    pmc_read(b);
+    uint64_t work = g_accesses.load() - w0;
+    if (!work) return c;
+    c.valid = true;
+#if defined(__linux__)
+    for (int i = 0; i < kNumPmc; ++i)
+    {
+        c.have[i] = !g_pmcFds[i].empty();
+        c.v[i] = (b[i] - a[i]) / (double)work;
+    }
+#endif
+    return c;
+}
+
+//====================================================
+// Cache / bandwidth QoS (--rdt, --resctrl, --cat-mask, --mba)
+//====================================================
+// Intel RDT through the Linux resctrl filesystem. --resctrl joins (or
+// creates) a group; --cat-mask / --mba write its L3 capacity bitmask and
+// memory-bandwidth throttle on every domain, in a private group when no
+// --resctrl is given, which is removed again at exit. Threads started later
+// inherit the group. The allocation in effect is reported, and the group's
+// MBM bandwidth and CMT LLC occupancy are sampled around every tier.
+struct RdtSample
+{
+    bool valid = false;
+    bool haveOcc = false, haveTotal = false, haveLocal = false;
+    double occ = 0;                 // llc_occupancy, bytes
+    double total = 0;               // mbm_total_bytes
+    double local = 0;               // mbm_local_bytes
+};
+
+struct RdtState
+{
+    bool on = false;
+    string dir;                     // group directory
+    bool created = false;           // made by us, removed at exit
+    vector<string> restore;         // original schemata lines of a group we did not create
+    vector<string> mon;             // mon_data/mon_L3_* of the group
+};
+
+static RdtState g_rdt;
+
+#if defined(__linux__)
+static const string kResctrlRoot = "/sys/fs/resctrl";
+
+static bool write_file(const string& path, const string& v)
+{
+    FILE* f = fopen(path.c_str(), "w");
+    if (!f) return false;
+    bool ok = fputs(v.c_str(), f) >= 0;
+    return (fclose(f) == 0) && ok;          // resctrl reports bad values on close
+}
+
+// "L3:0=7ff;1=7ff" -> domain ids and values of that resource's line.
+static vector<pair<string, string>> schemata_line(const string& schemata, const string& res)
+{
+    vector<pair<string, string>> v;
+    size_t pos = 0;
+    while (pos < schemata.size())
+    {
+        size_t end = schemata.find('\n', pos);
+        if (end == string::npos) end = schemata.size();
+        string line = schemata.substr(pos, end - pos);
+        pos = end + 1;
+        while (!line.empty() && line[0] == ' ') line.erase(0, 1);
+        if (line.compare(0, res.size() + 1, res + ":") != 0) continue;
+        line = line.substr(res.size() + 1);
+        for (size_t i = 0; i < line.size();)
+        {
+            size_t e = line.find(';', i);
+            if (e == string::npos) e = line.size();
+            string d = line.substr(i, e - i);
+            size_t eq = d.find('=');
+            if (eq != string::npos) v.push_back({ d.substr(0, eq), d.substr(eq + 1) });
+            i = e + 1;
+        }
+    }
+    return v;
+}
+
+static string read_all(const string& path)
+{
+    ifstream f(path);
+    return string(istreambuf_iterator<char>(f), istreambuf_iterator<char>());
+}
+
+// Joins `group` (relative to the resctrl root, created if missing) or a
+// private group, applies the mask / throttle and moves this process in.
+static bool rdt_setup(const string& group, const string& catMask, int mbaPct)
+{
+    struct stat st;
+    if (stat((kResctrlRoot + "/info").c_str(), &st) != 0)
+    {
+        cerr << "resctrl is not mounted (mount -t resctrl resctrl " << kResctrlRoot << ")\n";
+        return false;
+    }
+    g_rdt.on = true;
+    if (group.empty() && catMask.empty() && mbaPct <= 0)
+    {
+        // Report only: the group this process already runs in.
+        string g = read_all("/proc/self/cpu_resctrl_groups");
+        size_t r = g.find("res:");
+        string rel = (r == string::npos) ? "/" : g.substr(r + 4, g.find('\n', r) - r - 4);
+        g_rdt.dir = kResctrlRoot + (rel == "/" ? "" : rel);
+    }
+    else
+    {
+        g_rdt.dir = kResctrlRoot + "/" + (group.empty() ? "cachebench." + to_string(getpid()) : group);
+        if (stat(g_rdt.dir.c_str(), &st) != 0)
+        {
+            if (mkdir(g_rdt.dir.c_str(), 0755) != 0)
+            {
+                cerr << "Cannot create resctrl group " << g_rdt.dir << ": " << strerror(errno) << "\n";
+                return false;
+            }
+            g_rdt.created = true;
+        }
+        string sch = read_all(g_rdt.dir + "/schemata");
+        auto apply = [&](const string& res, const string& val)
+        {
+            vector<pair<string, string>> doms = schemata_line(sch, res);
+            if (doms.empty())
+            {
+                cerr << "resctrl: no " << res << " resource in " << g_rdt.dir << "/schemata\n";
+                return false;
+            }
+            string line = res + ":", orig = line;
+            for (size_t i = 0; i < doms.size(); ++i)
+            {
+                line += (i ? ";" : "") + doms[i].first + "=" + val;
+                orig += (i ? ";" : "") + doms[i].first + "=" + doms[i].second;
+            }
+            // Someone else's group gets its allocation back at exit.
+            if (!g_rdt.created) g_rdt.restore.push_back(orig);
+            if (write_file(g_rdt.dir + "/schemata", line + "\n")) return true;
+            cerr << "resctrl: writing '" << line << "' failed: "
+                 << read_text(kResctrlRoot + "/info/last_cmd_status") << "\n";
+            return false;
+        };
+        if (!catMask.empty() && !apply("L3", catMask)) return false;
+        if (mbaPct > 0 && !apply("MB", to_string(mbaPct))) return false;
+        if (!write_file(g_rdt.dir + "/tasks", to_string(getpid()) + "\n"))
+        {
+            cerr << "Cannot join resctrl group " << g_rdt.dir << ": " << strerror(errno) << "\n";
+            return false;
+        }
+    }
+
+    if (DIR* d = opendir((g_rdt.dir + "/mon_data").c_str()))
+    {
+        while (dirent* e = readdir(d))
+            if (strncmp(e->d_name, "mon_L3_", 7) == 0)
+                g_rdt.mon.push_back(g_rdt.dir + "/mon_data/" + e->d_name);
+        closedir(d);
+        sort(g_rdt.mon.begin(), g_rdt.mon.end());
+    }
+    return true;
+}
+
+static void rdt_teardown()
+{
+    for (const string& line : g_rdt.restore)
+        if (!write_file(g_rdt.dir + "/schemata", line + "\n"))
+            cerr << "warning: cannot restore '" << line << "' in " << g_rdt.dir << "/schemata\n";
+    g_rdt.restore.clear();
+    if (!g_rdt.created) return;
+    write_file(kResctrlRoot + "/tasks", to_string(getpid()) + "\n");
+    if (rmdir(g_rdt.dir.c_str()) != 0)
+        cerr << "warning: cannot remove resctrl group " << g_rdt.dir << "\n";
+    g_rdt.created = false;
+}
+
+// Sums the group's monitoring counters over all L3 domains.
+static RdtSample rdt_sample()
+{
+    RdtSample s;
+    if (!g_rdt.on || g_rdt.mon.empty()) return s;
+    auto add = [](const string& path, bool& have, double& v)
+    {
+        string t = read_text(path);
+        if (t.empty() || !isdigit((unsigned char)t[0])) return;   // "Unavailable"
+        have = true;
+        v += (double)strtoull(t.c_str(), nullptr, 10);
+    };
+    for (const string& m : g_rdt.mon)
+    {
+        add(m + "/llc_occupancy", s.haveOcc, s.occ);
+        add(m + "/mbm_total_bytes", s.haveTotal, s.total);
+        add(m + "/mbm_local_bytes", s.haveLocal, s.local);
+    }
+    s.valid = s.haveOcc || s.haveTotal || s.haveLocal;
+    return s;
+}
+
+// Mask, ways and approximate capacity per L3 domain, MBA throttle, and the
+// cgroup limits that also shape what this run can get.
+static void rdt_report(size_t l3Bytes)
+{
+    cout << "RDT:    group " << g_rdt.dir << (g_rdt.created ? " (created)" : "") << "\n";
+    string sch = read_all(g_rdt.dir + "/schemata");
+    string full = read_text(kResctrlRoot + "/info/L3/cbm_mask");
+    int fullWays = full.empty() ? 0 : __builtin_popcountll(strtoull(full.c_str(), nullptr, 16));
+    for (const auto& d : schemata_line(sch, "L3"))
+    {
+        int ways = __builtin_popcountll(strtoull(d.second.c_str(), nullptr, 16));
+        cout << "        L3 domain " << d.first << ": mask 0x" << d.second << ", " << ways;
+        if (fullWays)
+            cout << " of " << fullWays << " ways (~" << fixed << setprecision(1)
+                 << (double)l3Bytes * ways / fullWays / 1048576.0 << " MB)";
+        cout << "\n";
+    }
+    for (const auto& d : schemata_line(sch, "MB"))
+        cout << "        MBA domain " << d.first << ": throttle " << d.second
+             << (read_text(kResctrlRoot + "/info/MB/delay_linear") == "0" ? "" : "%") << "\n";
+    cout << "        monitoring: "
+         << (g_rdt.mon.empty() ? string("unavailable")
+                               : to_string(g_rdt.mon.size()) + " L3 domain(s)") << "\n";
+
+    // cgroup v2: "0::/path"; v1 lines are skipped.
+    string cg = read_all("/proc/self/cgroup");
+    size_t p = cg.find("0::");
+    if (p != string::npos)
+    {
+        string rel = cg.substr(p + 3, cg.find('\n', p) - p - 3);
+        string dir = "/sys/fs/cgroup" + rel;
+        auto val = [&](const char* f)
+        {
+            string v = read_text(dir + "/" + f);
+            return v.empty() ? string("-") : v;
+        };
+        cout << "Cgroup: " << rel << " (cpuset " << val("cpuset.cpus.effective") << ", mems "
+             << val("cpuset.mems.effective") << ", cpu.max " << val("cpu.max") << ", memory.max "
+             << val("memory.max") << ")\n";
+    }
+}
+#else
+static bool rdt_setup(const string&, const string&, int)
+{
+    cerr << "resctrl (--rdt, --resctrl, --cat-mask, --mba) is Linux-only\n";
+    return false;
+}
+static void rdt_teardown() {}
+static RdtSample rdt_sample() { return RdtSample(); }
+static void rdt_report(size_t) {}
+#endif
+
+// Bandwidth and occupancy of the group between two samples.
+struct RdtDelta
+{
+    bool valid = false;
+    double totalGBs = -1, localGBs = -1;    // -1 = counter unavailable
+    double occMB = -1;                      // occupancy at the end
+};
+
+static RdtDelta rdt_delta(const RdtSample& a, const RdtSample& b, double sec)
+{
+    RdtDelta d;
+    if (!a.valid || !b.valid || sec <= 0) return d;
+    d.valid = true;
+    if (b.haveTotal) d.totalGBs = (b.total - a.total) / sec / 1e9;
+    if (b.haveLocal) d.localGBs = (b.local - a.local) / sec / 1e9;
+    if (b.haveOcc) d.occMB = b.occ / 1048576.0;
+    return d;
+}
+
+//====================================================
+// Benchmark functions (read/write/copy/latency)
+//====================================================
+// One untimed/timed pass of a bandwidth kernel over [dst|src, +bytes).
+// The return value is folded into sink64 so the pass cannot be elided.
+using PassFn = double (*)(char* dst, const char* src, size_t bytes);
+
+// Kernel templates: T is the element (uint8..uint64, float, double or a
+// 16/32/64-byte vector), U the number of independent accumulators / stores
+// per loop iteration and S the distance between accessed elements, in
+// elements. Elements move through memcpy, so any alignment and punning is
+// fine and the compiler picks the load/store width from T. The scalar entry
+// of --kernel is tread<double, 1, 1> / twrite<double, 1, 1>; --tkernel
+// selects the other instantiations.
+template <typename T>
+static inline double fold_lanes(const T& v)
+{
+    if constexpr (is_arithmetic<T>::value) return (double)v;
+    else
+    {
+        uint64_t lanes[sizeof(T) / sizeof(uint64_t)];
+        memcpy(lanes, &v, sizeof(T));
+        uint64_t r = 0;
+        for (uint64_t l : lanes) r ^= l;
+        return (double)r;
+    }
+}
+
+template <typename T, int U, size_t S>
+__attribute__((always_inline)) static inline double tread_body(const char* src, size_t bytes)
+{
+    const size_t step = S * sizeof(T);
+    size_t n = bytes / step, i = 0;
+    T acc[U];
+    memset(acc, 0, sizeof(acc));
+    for (; i + U <= n; i += U)
+        for (int u = 0; u < U; ++u)
+        {
+            T v;
+            memcpy(&v, src + (i + u) * step, sizeof(T));
+            acc[u] += v;
+        }
+    for (; i < n; ++i)
+    {
+        T v;
+        memcpy(&v, src + i * step, sizeof(T));
+        acc[0] += v;
+    }
+    for (int u = 1; u < U; ++u) acc[0] += acc[u];
+    return fold_lanes(acc[0]);
+}
+
+// Stores the element index so the loop cannot become a memset call.
+template <typename T, int U, size_t S>
+__attribute__((always_inline)) static inline double twrite_body(char* dst, size_t bytes)
+{
+    const size_t step = S * sizeof(T);
+    size_t n = bytes / step, i = 0;
+    for (; i + U <= n; i += U)
+        for (int u = 0; u < U; ++u)
+        {
+            T v{};
+            v += (uint64_t)(i + u);
+            memcpy(dst + (i + u) * step, &v, sizeof(T));
+        }
+    for (; i < n; ++i)
+    {
+        T v{};
+        v += (uint64_t)i;
+        memcpy(dst + i * step, &v, sizeof(T));
+    }
+    return 0;
+}
+
+// U loads, then U stores; the empty asm keeps GCC from turning the loop
+// into a memcpy call (libc memcpy is what the Copy column measures).
+template <typename T, int U>
+__attribute__((always_inline)) static inline double tcopy_body(char* dst, const char* src,
+                                                               size_t bytes)
+{
+    size_t n = bytes / sizeof(T), i = 0;
+    for (; i + U <= n; i += U)
+    {
+        T v[U];
+        for (int u = 0; u < U; ++u) memcpy(&v[u], src + (i + u) * sizeof(T), sizeof(T));
+        for (int u = 0; u < U; ++u) memcpy(dst + (i + u) * sizeof(T), &v[u], sizeof(T));
+        asm volatile("" ::: "memory");
+    }
+    memcpy(dst + i * sizeof(T), src + i * sizeof(T), bytes - i * sizeof(T));
+    return 0;
+}
+
+template <typename T, int U, size_t S>
+static double tread(char*, const char* src, size_t bytes)
+{
+    return tread_body<T, U, S>(src, bytes);
+}
+
+template <typename T, int U, size_t S>
+static double twrite(char* dst, const char*, size_t bytes)
+{
+    return twrite_body<T, U, S>(dst, bytes);
+}
+
+template <typename T, int U>
+static double tcopy(char* dst, const char* src, size_t bytes)
+{
+    return tcopy_body<T, U>(dst, src, bytes);
+}
+
+static double copy_pass(char* dst, const char* src, size_t bytes)
+{
+    memcpy(dst, src, bytes);
+    return 0;
+}
+
+//====================================================
+// Vector kernels (selected with --kernel)
+//====================================================
+// The scalar read above is bound by the add chain on `sum`. These kernels
+// keep eight independent integer accumulators (no FP assists on whatever
+// bit patterns the latency chain left behind) and use one ISA each. x86
+// variants are compiled with target attributes and picked at run time, so
+// -march=native is not required to reach them.
+// Streaming (non-temporal) stores bypass the caches and skip the
+// read-for-ownership of the target line. They need vector-aligned targets,
+// so an unaligned head and the ragged tail go through plain stores.
+static size_t nt_head(const char* p, size_t align, size_t bytes)
+{
+    size_t h = (align - ((uintptr_t)p & (align - 1))) & (align - 1);
+    return min(h, bytes);
+}
+
+#if defined(CB_X86)
+__attribute__((target("sse2")))
+static double read_sse(char*, const char* src, size_t bytes)
+{
+    auto* p = reinterpret_cast<const __m128i*>(src);
+    size_t n = bytes / sizeof(__m128i), i = 0;
+    __m128i a0 = _mm_setzero_si128(), a1 = a0, a2 = a0, a3 = a0,
+            a4 = a0, a5 = a0, a6 = a0, a7 = a0;
+    for (; i + 8 <= n; i += 8)
+    {
+        a0 = _mm_add_epi64(a0, _mm_loadu_si128(p + i + 0));
+        a1 = _mm_add_epi64(a1, _mm_loadu_si128(p + i + 1));
+        a2 = _mm_add_epi64(a2, _mm_loadu_si128(p + i + 2));
+        a3 = _mm_add_epi64(a3, _mm_loadu_si128(p + i + 3));
+        a4 = _mm_add_epi64(a4, _mm_loadu_si128(p + i + 4));
+        a5 = _mm_add_epi64(a5, _mm_loadu_si128(p + i + 5));
+        a6 = _mm_add_epi64(a6, _mm_loadu_si128(p + i + 6));
+        a7 = _mm_add_epi64(a7, _mm_loadu_si128(p + i + 7));
+    }
+    for (; i < n; ++i) a0 = _mm_add_epi64(a0, _mm_loadu_si128(p + i));
+    a0 = _mm_add_epi64(_mm_add_epi64(_mm_add_epi64(a0, a1), _mm_add_epi64(a2, a3)),
+                       _mm_add_epi64(_mm_add_epi64(a4, a5), _mm_add_epi64(a6, a7)));
+    uint64_t lanes[2];
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), a0);
+    return (double)(lanes[0] ^ lanes[1]);
+}
+
+__attribute__((target("sse2")))
+static double write_sse(char* dst, const char*, size_t bytes)
+{
+    auto* p = reinterpret_cast<__m128i*>(dst);
+    size_t n = bytes / sizeof(__m128i);
+    const __m128i v = _mm_set1_epi64x(0x0101010101010101LL);
+    for (size_t i = 0; i < n; ++i) _mm_storeu_si128(p + i, v);
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static double read_avx2(char*, const char* src, size_t bytes)
+{
+    auto* p = reinterpret_cast<const __m256i*>(src);
+    size_t n = bytes / sizeof(__m256i), i = 0;
+    __m256i a0 = _mm256_setzero_si256(), a1 = a0, a2 = a0, a3 = a0,
+            a4 = a0, a5 = a0, a6 = a0, a7 = a0;
+    for (; i + 8 <= n; i += 8)
+    {
+        a0 = _mm256_add_epi64(a0, _mm256_loadu_si256(p + i + 0));
+        a1 = _mm256_add_epi64(a1, _mm256_loadu_si256(p + i + 1));
+        a2 = _mm256_add_epi64(a2, _mm256_loadu_si256(p + i + 2));
+        a3 = _mm256_add_epi64(a3, _mm256_loadu_si256(p + i + 3));
+        a4 = _mm256_add_epi64(a4, _mm256_loadu_si256(p + i + 4));
+        a5 = _mm256_add_epi64(a5, _mm256_loadu_si256(p + i + 5));
+        a6 = _mm256_add_epi64(a6, _mm256_loadu_si256(p + i + 6));
+        a7 = _mm256_add_epi64(a7, _mm256_loadu_si256(p + i + 7));
+    }
+    for (; i < n; ++i) a0 = _mm256_add_epi64(a0, _mm256_loadu_si256(p + i));
+    a0 = _mm256_add_epi64(_mm256_add_epi64(_mm256_add_epi64(a0, a1), _mm256_add_epi64(a2, a3)),
+                          _mm256_add_epi64(_mm256_add_epi64(a4, a5), _mm256_add_epi64(a6, a7)));
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), a0);
+    return (double)(lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3]);
+}
+
+__attribute__((target("avx2")))
+static double write_avx2(char* dst, const char*, size_t bytes)
+{
+    auto* p = reinterpret_cast<__m256i*>(dst);
+    size_t n = bytes / sizeof(__m256i);
+    const __m256i v = _mm256_set1_epi64x(0x0101010101010101LL);
+    for (size_t i = 0; i < n; ++i) _mm256_storeu_si256(p + i, v);
+    return 0;
+}
+
+__attribute__((target("avx512f")))
+static double read_avx512(char*, const char* src, size_t bytes)
+{
+    auto* p = reinterpret_cast<const __m512i*>(src);
+    size_t n = bytes / sizeof(__m512i), i = 0;
+    __m512i a0 = _mm512_setzero_si512(), a1 = a0, a2 = a0, a3 = a0,
+            a4 = a0, a5 = a0, a6 = a0, a7 = a0;
+    for (; i + 8 <= n; i += 8)
+    {
+        a0 = _mm512_add_epi64(a0, _mm512_loadu_si512(p + i + 0));
+        a1 = _mm512_add_epi64(a1, _mm512_loadu_si512(p + i + 1));
+        a2 = _mm512_add_epi64(a2, _mm512_loadu_si512(p + i + 2));
+        a3 = _mm512_add_epi64(a3, _mm512_loadu_si512(p + i + 3));
+        a4 = _mm512_add_epi64(a4, _mm512_loadu_si512(p + i + 4));
+        a5 = _mm512_add_epi64(a5, _mm512_loadu_si512(p + i + 5));
+        a6 = _mm512_add_epi64(a6, _mm512_loadu_si512(p + i + 6));
+        a7 = _mm512_add_epi64(a7, _mm512_loadu_si512(p + i + 7));
+    }
+    for (; i < n; ++i) a0 = _mm512_add_epi64(a0, _mm512_loadu_si512(p + i));
+    a0 = _mm512_add_epi64(_mm512_add_epi64(_mm512_add_epi64(a0, a1), _mm512_add_epi64(a2, a3)),
+                          _mm512_add_epi64(_mm512_add_epi64(a4, a5), _mm512_add_epi64(a6, a7)));
+    uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, a0);
+    uint64_t r = 0;
+    for (uint64_t v : lanes) r ^= v;
+    return (double)r;
+}
+
+__attribute__((target("avx512f")))
+static double write_avx512(char* dst, const char*, size_t bytes)
+{
+    auto* p = reinterpret_cast<__m512i*>(dst);
+    size_t n = bytes / sizeof(__m512i);
+    const __m512i v = _mm512_set1_epi64(0x0101010101010101LL);
+    for (size_t i = 0; i < n; ++i) _mm512_storeu_si512(p + i, v);
+    return 0;
+}
+
+__attribute__((target("sse2")))
+static double write_nt_sse(char* dst, const char*, size_t bytes)
+{
+    size_t h = nt_head(dst, 16, bytes);
+    memset(dst, 1, h);
+    auto* p = reinterpret_cast<__m128i*>(dst + h);
+    size_t n = (bytes - h) / sizeof(__m128i);
+    const __m128i v = _mm_set1_epi64x(0x0101010101010101LL);
+    for (size_t i = 0; i < n; ++i) _mm_stream_si128(p + i, v);
+    _mm_sfence();
+    memset(dst + h + n * sizeof(__m128i), 1, bytes - h - n * sizeof(__m128i));
+    return 0;
+}
+
+__attribute__((target("sse2")))
+static double copy_nt_sse(char* dst, const char* src, size_t bytes)
+{
+    size_t h = nt_head(dst, 16, bytes);
+    memcpy(dst, src, h);
+    auto* d = reinterpret_cast<__m128i*>(dst + h);
+    auto* s = reinterpret_cast<const __m128i*>(src + h);
+    size_t n = (bytes - h) / sizeof(__m128i), i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m128i v0 = _mm_loadu_si128(s + i + 0), v1 = _mm_loadu_si128(s + i + 1);
+        __m128i v2 = _mm_loadu_si128(s + i + 2), v3 = _mm_loadu_si128(s + i + 3);
+        _mm_stream_si128(d + i + 0, v0); _mm_stream_si128(d + i + 1, v1);
+        _mm_stream_si128(d + i + 2, v2); _mm_stream_si128(d + i + 3, v3);
+    }
+    for (; i < n; ++i) _mm_stream_si128(d + i, _mm_loadu_si128(s + i));
+    _mm_sfence();
+    size_t done = h + n * sizeof(__m128i);
+    memcpy(dst + done, src + done, bytes - done);
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static double write_nt_avx2(char* dst, const char*, size_t bytes)
+{
+    size_t h = nt_head(dst, 32, bytes);
+    memset(dst, 1, h);
+    auto* p = reinterpret_cast<__m256i*>(dst + h);
+    size_t n = (bytes - h) / sizeof(__m256i);
+    const __m256i v = _mm256_set1_epi64x(0x0101010101010101LL);
+    for (size_t i = 0; i < n; ++i) _mm256_stream_si256(p + i, v);
+    _mm_sfence();
+    memset(dst + h + n * sizeof(__m256i), 1, bytes - h - n * sizeof(__m256i));
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static double copy_nt_avx2(char* dst, const char* src, size_t bytes)
+{
+    size_t h = nt_head(dst, 32, bytes);
+    memcpy(dst, src, h);
+    auto* d = reinterpret_cast<__m256i*>(dst + h);
+    auto* s = reinterpret_cast<const __m256i*>(src + h);
+    size_t n = (bytes - h) / sizeof(__m256i), i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m256i v0 = _mm256_loadu_si256(s + i + 0), v1 = _mm256_loadu_si256(s + i + 1);
+        __m256i v2 = _mm256_loadu_si256(s + i + 2), v3 = _mm256_loadu_si256(s + i + 3);
+        _mm256_stream_si256(d + i + 0, v0); _mm256_stream_si256(d + i + 1, v1);
+        _mm256_stream_si256(d + i + 2, v2); _mm256_stream_si256(d + i + 3, v3);
+    }
+    for (; i < n; ++i) _mm256_stream_si256(d + i, _mm256_loadu_si256(s + i));
+    _mm_sfence();
+    size_t done = h + n * sizeof(__m256i);
+    memcpy(dst + done, src + done, bytes - done);
+    return 0;
+}
+
+__attribute__((target("avx512f")))
+static double write_nt_avx512(char* dst, const char*, size_t bytes)
+{
+    size_t h = nt_head(dst, 64, bytes);
+    memset(dst, 1, h);
+    auto* p = reinterpret_cast<__m512i*>(dst + h);
+    size_t n = (bytes - h) / sizeof(__m512i);
+    const __m512i v = _mm512_set1_epi64(0x0101010101010101LL);
+    for (size_t i = 0; i < n; ++i) _mm512_stream_si512(p + i, v);
+    _mm_sfence();
+    memset(dst + h + n * sizeof(__m512i), 1, bytes - h - n * sizeof(__m512i));
+    return 0;
+}
+
+__attribute__((target("avx512f")))
+static double copy_nt_avx512(char* dst, const char* src, size_t bytes)
+{
+    size_t h = nt_head(dst, 64, bytes);
+    memcpy(dst, src, h);
+    auto* d = reinterpret_cast<__m512i*>(dst + h);
+    auto* s = reinterpret_cast<const __m512i*>(src + h);
+    size_t n = (bytes - h) / sizeof(__m512i), i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        __m512i v0 = _mm512_loadu_si512(s + i + 0), v1 = _mm512_loadu_si512(s + i + 1);
+        __m512i v2 = _mm512_loadu_si512(s + i + 2), v3 = _mm512_loadu_si512(s + i + 3);
+        _mm512_stream_si512(d + i + 0, v0); _mm512_stream_si512(d + i + 1, v1);
+        _mm512_stream_si512(d + i + 2, v2); _mm512_stream_si512(d + i + 3, v3);
+    }
+    for (; i < n; ++i) _mm512_stream_si512(d + i, _mm512_loadu_si512(s + i));
+    _mm_sfence();
+    size_t done = h + n * sizeof(__m512i);
+    memcpy(dst + done, src + done, bytes - done);
+    return 0;
+}
+
+static bool has_sse()    { return true; } // baseline on x86-64
+static bool has_avx2()   { return __builtin_cpu_supports("avx2"); }
+static bool has_avx512() { return __builtin_cpu_supports("avx512f"); }
+#endif // CB_X86
+
+#if defined(__ARM_NEON)
+static double read_neon(char*, const char* src, size_t bytes)
+{
+    auto* p = reinterpret_cast<const uint64_t*>(src);
+    size_t n = bytes / 16, i = 0;
+    uint64x2_t a0 = vdupq_n_u64(0), a1 = a0, a2 = a0, a3 = a0,
+               a4 = a0, a5 = a0, a6 = a0, a7 = a0;
+    for (; i + 8 <= n; i += 8)
+    {
+        a0 = vaddq_u64(a0, vld1q_u64(p + 2 * (i + 0)));
+        a1 = vaddq_u64(a1, vld1q_u64(p + 2 * (i + 1)));
+        a2 = vaddq_u64(a2, vld1q_u64(p + 2 * (i + 2)));
+        a3 = vaddq_u64(a3, vld1q_u64(p + 2 * (i + 3)));
+        a4 = vaddq_u64(a4, vld1q_u64(p + 2 * (i + 4)));
+        a5 = vaddq_u64(a5, vld1q_u64(p + 2 * (i + 5)));
+        a6 = vaddq_u64(a6, vld1q_u64(p + 2 * (i + 6)));
+        a7 = vaddq_u64(a7, vld1q_u64(p + 2 * (i + 7)));
+    }
+    for (; i < n; ++i) a0 = vaddq_u64(a0, vld1q_u64(p + 2 * i));
+    a0 = vaddq_u64(vaddq_u64(vaddq_u64(a0, a1), vaddq_u64(a2, a3)),
+                   vaddq_u64(vaddq_u64(a4, a5), vaddq_u64(a6, a7)));
+    return (double)(vgetq_lane_u64(a0, 0) ^ vgetq_lane_u64(a0, 1));
+}
+
+static double write_neon(char* dst, const char*, size_t bytes)
+{
+    auto* p = reinterpret_cast<uint64_t*>(dst);
+    size_t n = bytes / 16;
+    const uint64x2_t v = vdupq_n_u64(0x0101010101010101ULL);
+    for (size_t i = 0; i < n; ++i) vst1q_u64(p + 2 * i, v);
+    return 0;
+}
+
+#if defined(__aarch64__)
+// STNP is the AArch64 non-temporal pair store; DMB orders it like SFENCE.
+static double write_nt_neon(char* dst, const char*, size_t bytes)
+{
+    size_t h = min<size_t>((32 - ((uintptr_t)dst & 31)) & 31, bytes);
+    memset(dst, 1, h);
+    char* p = dst + h;
+    size_t n = (bytes - h) / 32;
+    const uint64x2_t v = vdupq_n_u64(0x0101010101010101ULL);
+    for (size_t i = 0; i < n; ++i)
+        asm volatile("stnp %q[a], %q[a], [%[p]]" :: [a] "w"(v), [p] "r"(p + 32 * i) : "memory");
+    asm volatile("dmb ishst" ::: "memory");
+    memset(p + 32 * n, 1, bytes - h - 32 * n);
+    return 0;
+}
+
+static double copy_nt_neon(char* dst, const char* src, size_t bytes)
+{
+    size_t h = min<size_t>((32 - ((uintptr_t)dst & 31)) & 31, bytes);
+    memcpy(dst, src, h);
+    char* d = dst + h;
+    auto* s = reinterpret_cast<const uint64_t*>(src + h);
+    size_t n = (bytes - h) / 32;
+    for (size_t i = 0; i < n; ++i)
+    {
+        uint64x2_t v0 = vld1q_u64(s + 4 * i), v1 = vld1q_u64(s + 4 * i + 2);
+        asm volatile("stnp %q[a], %q[b], [%[p]]" :: [a] "w"(v0), [b] "w"(v1), [p] "r"(d + 32 * i) : "memory");
+    }
+    asm volatile("dmb ishst" ::: "memory");
+    size_t done = h + 32 * n;
+    memcpy(dst + done, src + done, bytes - done);
+    return 0;
+}
+#else
+// 32-bit NEON has no non-temporal store; fall back to the regular kernels.
+static double write_nt_neon(char* dst, const char* src, size_t bytes) { return write_neon(dst, src, bytes); }
+static double copy_nt_neon(char* dst, const char* src, size_t bytes) { memcpy(dst, src, bytes); return 0; }
+#endif
+
+static bool has_neon() { return true; }
+#endif // __ARM_NEON
+
+// Scalar streaming stores: MOVNTI on x86-64, STNP of a GPR pair on AArch64.
+// Other targets have no scalar NT store and use plain stores. Like the vector
+// NT kernels, the unaligned head and the ragged tail use plain stores.
+static double write_nt_pass(char* dst, const char*, size_t bytes)
+{
+    size_t h = nt_head(dst, sizeof(uint64_t), bytes);
+    memset(dst, 1, h);
+    size_t els = (bytes - h) / sizeof(uint64_t);
+    auto* p = reinterpret_cast<uint64_t*>(dst + h);
+    const uint64_t v = 0x0101010101010101ULL;
+#if defined(__x86_64__)
+    for (size_t i = 0; i < els; ++i) _mm_stream_si64(reinterpret_cast<long long*>(p + i), (long long)v);
+    _mm_sfence();
+#elif defined(__aarch64__)
+    size_t i = 0;
+    for (; i + 2 <= els; i += 2)
+        asm volatile("stnp %x[a], %x[b], [%[p]]" :: [a] "r"(v), [b] "r"(v), [p] "r"(p + i) : "memory");
+    for (; i < els; ++i) p[i] = v;
+    asm volatile("dmb ishst" ::: "memory");
+#else
+    for (size_t i = 0; i < els; ++i) p[i] = v;
+#endif
+    size_t done = h + els * sizeof(uint64_t);
+    memset(dst + done, 1, bytes - done);
+    return 0;
+}
+
+static double copy_nt_pass(char* dst, const char* src, size_t bytes)
+{
+    size_t h = nt_head(dst, sizeof(uint64_t), bytes);
+    memcpy(dst, src, h);
+    size_t els = (bytes - h) / sizeof(uint64_t);
+    auto* d = reinterpret_cast<uint64_t*>(dst + h);
+    const char* s = src + h;                // may be unaligned: loads go through memcpy
+    auto load = [s](size_t i)
+    {
+        uint64_t v;
+        memcpy(&v, s + i * sizeof(uint64_t), sizeof(v));
+        return v;
+    };
+#if defined(__x86_64__)
+    for (size_t i = 0; i < els; ++i) _mm_stream_si64(reinterpret_cast<long long*>(d + i), (long long)load(i));
+    _mm_sfence();
+#elif defined(__aarch64__)
+    size_t i = 0;
+    for (; i + 2 <= els; i += 2)
+        asm volatile("stnp %x[a], %x[b], [%[p]]" :: [a] "r"(load(i)), [b] "r"(load(i + 1)), [p] "r"(d + i)
+                     : "memory");
+    for (; i < els; ++i) d[i] = load(i);
+    asm volatile("dmb ishst" ::: "memory");
+#else
+    memcpy(d, s, els * sizeof(uint64_t));
+#endif
+    size_t done = h + els * sizeof(uint64_t);
+    memcpy(dst + done, src + done, bytes - done);
+    return 0;
+}
+
+static bool has_scalar() { return true; }
+
+struct Kernel
+{
+    const char* name;
+    bool (*available)();
+    PassFn read;
+    PassFn write;
+    PassFn write_nt;            // streaming-store write
+    PassFn copy_nt;             // regular loads, streaming stores
+};
+
+// Ordered narrowest to widest; "auto" picks the last available entry.
+static const Kernel kKernels[] =
+{
+    { "scalar", has_scalar, tread<double, 1, 1>, twrite<double, 1, 1>, write_nt_pass, copy_nt_pass },
+#if defined(CB_X86)
+    { "sse",    has_sse,    read_sse,    write_sse,    write_nt_sse,    copy_nt_sse    },
+    { "avx2",   has_avx2,   read_avx2,   write_avx2,   write_nt_avx2,   copy_nt_avx2   },
+    { "avx512", has_avx512, read_avx512, write_avx512, write_nt_avx512, copy_nt_avx512 },
+#endif
+#if defined(__ARM_NEON)
+    { "neon",   has_neon,   read_neon,   write_neon,   write_nt_neon,   copy_nt_neon   },
+#endif
+};
+
+static const Kernel* g_kernel = &kKernels[0];
+
+static const Kernel* find_kernel(const string& name)
+{
+    const Kernel* best = nullptr;
+    for (const Kernel& k : kKernels)
+    {
+        if (name == "auto" && k.available()) best = &k;
+        else if (name == k.name) return k.available() ? &k : nullptr;
+    }
+    return best;
+}
+
+// Runs `pass` over the buffer on `threads` pinned threads. Each thread owns a
+// cache-line-aligned slice, warms it, then all threads are released together
+// from a barrier for every repetition; thread 0 feeds the slowest thread's
+// time to the RepLoop and decides when to stop. Returns aggregate GB/s
+// (bytes moved by all threads / slowest thread's time); per-thread median
+// GB/s go to *perThread.
+static Stats bw_gbs(PassFn pass, char* dst, char* src, size_t bytes, int iters,
+                    int threads, vector<double>* perThread)
+{
+    RepLoop loop(iters);
+    if (threads <= 1)
+    {
+        sink64 ^= (uint64_t)pass(dst, src, bytes); // warmup
+        g_accesses += bytes / kLine;
+        bool done = false;
+        while (!done)
+        {
+            uint64_t t0 = tnow();
+            double v = pass(dst, src, bytes);
+            uint64_t t1 = tnow();
+            done = loop.add(tsec(t0, t1));
+            sink64 ^= (uint64_t)v;
+            g_accesses += bytes / kLine;
+        }
+        return loop.stats([&](double sec) { return bytes / sec / 1e9; });
+    }
+
+    size_t slice = (bytes / threads) & ~(size_t)(kLine - 1);
+    if (slice == 0) slice = kLine;
+    const vector<int>& cpus = online_cpus();
+    vector<vector<double>> times(threads);
+    vector<uint64_t> sinks(threads);
+    SpinBarrier bar(threads);
+    atomic<bool> stop{false};
+    vector<thread> pool;
+
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&, t]
+        {
+            pin_thread(cpus[t % cpus.size()]);
+            char* d = dst + t * slice;
+            char* s = src + t * slice;
+            uint64_t local = (uint64_t)pass(d, s, slice); // warmup
+            uint64_t passes = 1;
+            for (;;)
+            {
+                bar.wait();
+                if (stop.load(memory_order_relaxed)) break;
+                uint64_t t0 = tnow();
+                double v = pass(d, s, slice);
+                uint64_t t1 = tnow();
+                times[t].push_back(tsec(t0, t1));
+                local ^= (uint64_t)v;
+                ++passes;
+                bar.wait();
+                if (t == 0)
+                {
+                    double slowest = 0;
+                    for (int u = 0; u < threads; ++u) slowest = max(slowest, times[u].back());
+                    if (loop.add(slowest)) stop.store(true, memory_order_relaxed);
+                }
+            }
+            sinks[t] = local;
+            g_accesses += passes * (slice / kLine);
+        });
+    }
+    for (auto& th : pool) th.join();
+    for (uint64_t v : sinks) sink64 ^= v;
+
+    if (perThread)
+    {
+        perThread->assign(threads, 0.0);
+        for (int t = 0; t < threads; ++t)
+        {
+            vector<double> v = times[t];
+            nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+            (*perThread)[t] = slice / v[v.size() / 2] / 1e9;
+        }
+    }
+    return loop.stats([&](double sec) { return (double)slice * threads / sec / 1e9; });
+}
+
+static Stats bw_read_gbs(char* buf, size_t bytes, int iters, int threads = 1,
+                         vector<double>* perThread = nullptr)
+{
+    return bw_gbs(g_kernel->read, buf, buf, bytes, iters, threads, perThread);
+}
+
+static Stats bw_write_gbs(char* buf, size_t bytes, int iters, int threads = 1,
+                          vector<double>* perThread = nullptr)
+{
+    return bw_gbs(g_kernel->write, buf, buf, bytes, iters, threads, perThread);
+}
+
+static Stats bw_copy_gbs(char* dst, char* src, size_t bytes, int iters, int threads = 1,
+                         vector<double>* perThread = nullptr)
+{
+    return bw_gbs(copy_pass, dst, src, bytes, iters, threads, perThread);
+}
+
+static Stats bw_write_nt_gbs(char* buf, size_t bytes, int iters, int threads = 1,
+                             vector<double>* perThread = nullptr)
+{
+    return bw_gbs(g_kernel->write_nt, buf, buf, bytes, iters, threads, perThread);
+}
+
+static Stats bw_copy_nt_gbs(char* dst, char* src, size_t bytes, int iters, int threads = 1,
+                            vector<double>* perThread = nullptr)
+{
+    return bw_gbs(g_kernel->copy_nt, dst, src, bytes, iters, threads, perThread);
+}
+
+// Links max(2 * chains, bytes / stride) slots into `chains` independent
+// rings that together follow one random permutation of the buffer, so every
+// ring spans the whole working set. Returns the head of each ring.
+// Slot orders the suite scheduler shuffled ahead of time (on an idle core,
+// while the previous suite ran), keyed by node count. The seed is fixed, so
+// a prepared order is the one build_chains would have drawn itself.
+static mutex g_slotsMu;
+static vector<pair<size_t, vector<size_t>>> g_slots;
+
+static vector<size_t> shuffled_slots(size_t nodes)
+{
+    {
+        lock_guard<mutex> lk(g_slotsMu);
+        for (size_t i = 0; i < g_slots.size(); ++i)
+            if (g_slots[i].first == nodes)
+            {
+                vector<size_t> v = move(g_slots[i].second);
+                g_slots.erase(g_slots.begin() + i);
+                return v;
+            }
+    }
+    vector<size_t> idx(nodes);
+    for (size_t i = 0; i < nodes; ++i) idx[i] = i;
+    mt19937_64 rng(1234567);
+    shuffle(idx.begin(), idx.end(), rng);
+    return idx;
+}
+
+static void prepare_slots(const vector<size_t>& counts)
+{
+    for (size_t n : counts)
+    {
+        vector<size_t> v = shuffled_slots(n);
+        lock_guard<mutex> lk(g_slotsMu);
+        g_slots.push_back({ n, move(v) });
+    }
+}
+
+static void clear_slots()
+{
+    lock_guard<mutex> lk(g_slotsMu);
+    g_slots.clear();
+}
+
+static vector<char*> build_chains(char* buf, size_t bytes, size_t stride, int chains = 1)
+{
+    size_t nodes = max<size_t>(2 * (size_t)chains, bytes / stride);
+    vector<size_t> idx = shuffled_slots(nodes);
+
+    vector<char*> heads;
+    for (int k = 0; k < chains; ++k)
+    {
+        size_t lo = nodes * k / chains, hi = nodes * (k + 1) / chains;
+        for (size_t i = lo; i + 1 < hi; ++i) 
+        {
+            auto slot = reinterpret_cast<char**>(buf + idx[i] * stride);
+            *slot = (buf + idx[i + 1] * stride);
+        }
+        *reinterpret_cast<char**>(buf + idx[hi - 1] * stride) = (buf + idx[lo] * stride);
+        heads.push_back(buf + idx[lo] * stride);
+    }
+    return heads;
+}
+
+// Dependent-load latency of the ring starting at `head`. The batch of derefs
+// per sample is doubled until one sample takes >= 200 us (which also warms
+// the ring), then samples are taken by the RepLoop. U derefs are unrolled
+// per loop iteration (--tkernel latency.ptr.xU); derefs stays a multiple.
+template <int U = 1>
+static Stats chase_latency(char* head, int iters = 3) 
+{
+    volatile char** p = reinterpret_cast<volatile char**>(head);
+
+    // warmup
+    for (size_t i = 0; i < 2000; ++i) 
+    {
+        p = (volatile char**)(*p);
+    }
+
+    auto batch = [&](uint64_t derefs)
+    {
+        uint64_t t0 = tnow();
+        for (uint64_t i = 0; i < derefs; i += U) 
+        {
+            for (int u = 0; u < U; ++u) p = (volatile char**)(*p);
+        }
+        uint64_t t1 = tnow();
+        g_accesses += derefs;
+        return tsec(t0, t1);
+    };
+
+    uint64_t derefs = 4096;
+    while (batch(derefs) < 200e-6 && derefs < (1ULL << 28)) derefs *= 2;
+
+    RepLoop loop(iters);
+    while (!loop.add(batch(derefs))) {}
+
+    sink64 ^= (uint64_t)(uintptr_t)p;
+    return loop.stats([&](double sec) { return sec * 1e9 / (double)derefs; });
+}
+
+static Stats latency_ns(char* buf, size_t bytes, size_t stride, int iters = 3) 
+{
+    return chase_latency(build_chains(buf, bytes, stride)[0], iters);
+}
+
+//====================================================
+// Templated kernel registry (--tkernel, --list-kernels)
+//====================================================
+// Instantiations of tread / twrite / tcopy / chase_latency, named
+// op.type.xU.sS (S in bytes). Vector elements use GCC vector types; on x86
+// the 256/512-bit ones go through target("avx2") / target("avx512f")
+// wrappers so one binary carries every width and -march is not needed.
+typedef uint64_t cb_v128 __attribute__((vector_size(16)));
+typedef uint64_t cb_v256 __attribute__((vector_size(32)));
+typedef uint64_t cb_v512 __attribute__((vector_size(64)));
+
+struct TKernel
+{
+    string name;
+    const char* op;                 // read | write | copy | latency
+    bool (*available)();
+    PassFn pass;                    // bandwidth kernels
+    Stats (*chase)(char*, int);     // latency kernels
+    size_t elemBytes;
+    int unroll;
+    size_t strideBytes;             // 0 = --stride (latency)
+};
+
+enum TkIsa { TkBase, TkAvx2, TkAvx512 };
+
+#if defined(CB_X86)
+template <typename T, int U, size_t S>
+__attribute__((target("avx2"))) static double tread_avx2(char*, const char* src, size_t bytes)
+{
+    return tread_body<T, U, S>(src, bytes);
+}
+
+template <typename T, int U, size_t S>
+__attribute__((target("avx2"))) static double twrite_avx2(char* dst, const char*, size_t bytes)
+{
+    return twrite_body<T, U, S>(dst, bytes);
+}
+
+template <typename T, int U>
+__attribute__((target("avx2"))) static double tcopy_avx2(char* dst, const char* src, size_t bytes)
+{
+    return tcopy_body<T, U>(dst, src, bytes);
+}
+
+template <typename T, int U, size_t S>
+__attribute__((target("avx512f"))) static double tread_avx512(char*, const char* src, size_t bytes)
+{
+    return tread_body<T, U, S>(src, bytes);
+}
+
+template <typename T, int U, size_t S>
+__attribute__((target("avx512f"))) static double twrite_avx512(char* dst, const char*, size_t bytes)
+{
+    return twrite_body<T, U, S>(dst, bytes);
+}
+
+template <typename T, int U>
+__attribute__((target("avx512f"))) static double tcopy_avx512(char* dst, const char* src,
+                                                              size_t bytes)
+{
+    return tcopy_body<T, U>(dst, src, bytes);
+}
+#endif
+
+template <int Isa, typename T, int U, size_t S>
+static void tk_add_rw(vector<TKernel>& v, const char* type, bool (*avail)())
+{
+    PassFn r = tread<T, U, S>, w = twrite<T, U, S>;
+#if defined(CB_X86)
+    if constexpr (Isa == TkAvx2) { r = tread_avx2<T, U, S>; w = twrite_avx2<T, U, S>; }
+    if constexpr (Isa == TkAvx512) { r = tread_avx512<T, U, S>; w = twrite_avx512<T, U, S>; }
+#endif
+    string sfx = string(".") + type + ".x" + to_string(U) + ".s" + to_string(S * sizeof(T));
+    v.push_back({ "read" + sfx, "read", avail, r, nullptr, sizeof(T), U, S * sizeof(T) });
+    v.push_back({ "write" + sfx, "write", avail, w, nullptr, sizeof(T), U, S * sizeof(T) });
+}
+
+template <int Isa, typename T, int U>
+static void tk_add_copy(vector<TKernel>& v, const char* type, bool (*avail)())
+{
+    PassFn c = tcopy<T, U>;
+#if defined(CB_X86)
+    if constexpr (Isa == TkAvx2) c = tcopy_avx2<T, U>;
+    if constexpr (Isa == TkAvx512) c = tcopy_avx512<T, U>;
+#endif
+    string name = string("copy.") + type + ".x" + to_string(U) + ".s" + to_string(sizeof(T));
+    v.push_back({ name, "copy", avail, c, nullptr, sizeof(T), U, sizeof(T) });
+}
+
+// Unroll 1/4/8 contiguous, and 1/8 with one element per cache line.
+template <int Isa, typename T>
+static void tk_add_type(vector<TKernel>& v, const char* type, bool (*avail)())
+{
+    constexpr size_t L = sizeof(T) < kLine ? kLine / sizeof(T) : 1;
+    tk_add_rw<Isa, T, 1, 1>(v, type, avail);
+    tk_add_rw<Isa, T, 4, 1>(v, type, avail);
+    tk_add_rw<Isa, T, 8, 1>(v, type, avail);
+    if constexpr (L > 1)
+    {
+        tk_add_rw<Isa, T, 1, L>(v, type, avail);
+        tk_add_rw<Isa, T, 8, L>(v, type, avail);
+    }
+    tk_add_copy<Isa, T, 1>(v, type, avail);
+    tk_add_copy<Isa, T, 4>(v, type, avail);
+    tk_add_copy<Isa, T, 8>(v, type, avail);
+}
+
+template <int U>
+static void tk_add_chase(vector<TKernel>& v)
+{
+    v.push_back({ "latency.ptr.x" + to_string(U), "latency", has_scalar, nullptr,
+                  chase_latency<U>, sizeof(void*), U, 0 });
+}
+
+static const vector<TKernel>& tkernels()
+{
+    static const vector<TKernel> v = []
+    {
+        vector<TKernel> r;
+        tk_add_type<TkBase, uint8_t>(r, "u8", has_scalar);
+        tk_add_type<TkBase, uint16_t>(r, "u16", has_scalar);
+        tk_add_type<TkBase, uint32_t>(r, "u32", has_scalar);
+        tk_add_type<TkBase, uint64_t>(r, "u64", has_scalar);
+        tk_add_type<TkBase, float>(r, "f32", has_scalar);
+        tk_add_type<TkBase, double>(r, "f64", has_scalar);
+#if defined(CB_X86)
+        tk_add_type<TkBase, cb_v128>(r, "v128", has_sse);
+        tk_add_type<TkAvx2, cb_v256>(r, "v256", has_avx2);
+        tk_add_type<TkAvx512, cb_v512>(r, "v512", has_avx512);
+#else
+        // Generic vectors: the compiler splits widths the target lacks.
+        tk_add_type<TkBase, cb_v128>(r, "v128", has_scalar);
+        tk_add_type<TkBase, cb_v256>(r, "v256", has_scalar);
+        tk_add_type<TkBase, cb_v512>(r, "v512", has_scalar);
+#endif
+        tk_add_chase<1>(r);
+        tk_add_chase<2>(r);
+        tk_add_chase<4>(r);
+        tk_add_chase<8>(r);
+        return r;
+    }();
+    return v;
+}
+
+static void listKernels()
+{
+    cout << left << setw(24) << "name" << setw(9) << "op" << right << setw(6) << "elem"
+         << setw(8) << "unroll" << setw(8) << "stride" << "  available\n";
+    for (const TKernel& k : tkernels())
+    {
+        cout << left << setw(24) << k.name << setw(9) << k.op << right << setw(6) << k.elemBytes
+             << setw(8) << k.unroll << setw(8)
+             << (k.strideBytes ? to_string(k.strideBytes) : string("--stride"))
+             << "  " << (k.available() ? "yes" : "no") << "\n";
+    }
+}
+
+// Comma-separated names; a trailing '*' matches a prefix, "all" everything.
+static bool select_tkernels(const string& list, vector<const TKernel*>& out)
+{
+    vector<string> pats;
+    for (size_t i = 0; i < list.size();)
+    {
+        size_t end = list.find(',', i);
+        if (end == string::npos) end = list.size();
+        if (end > i) pats.push_back(list.substr(i, end - i));
+        i = end + 1;
+    }
+    for (const string& p : pats)
+    {
+        bool any = false;
+        for (const TKernel& k : tkernels())
+        {
+            bool hit = p == "all" || p == k.name ||
+                       (p.back() == '*' && k.name.compare(0, p.size() - 1, p, 0, p.size() - 1) == 0);
+            if (!hit) continue;
+            any = true;
+            if (!k.available() || find(out.begin(), out.end(), &k) != out.end()) continue;
+            out.push_back(&k);
+        }
+        if (!any)
+        {
+            cerr << "Unknown --tkernel '" << p << "' (see --list-kernels)\n";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Runs the selected kernels at every tier: reads first over a 0x01 fill (no
+// FP assists on leftover pointers), then writes, copies and latency chases.
+// Bandwidth is bytes of the tier per second whatever the stride, i.e. the
+// line rate for one element per line.
+static void runTKernels(char* b1, char* b2, const vector<pair<const char*, size_t>>& tiers,
+                        const vector<const TKernel*>& ks, size_t stride, int iters, int threads)
+{
+    static const char* const kOps[] = { "read", "write", "copy", "latency" };
+    vector<vector<double>> res(ks.size(), vector<double>(tiers.size(), 0.0));
+    for (size_t t = 0; t < tiers.size(); ++t)
+    {
+        size_t bytes = tiers[t].second * 1024ULL;
+        memset(b1, 1, bytes);
+        char* head = nullptr;
+        for (const char* op : kOps)
+            for (size_t i = 0; i < ks.size(); ++i)
+            {
+                const TKernel& k = *ks[i];
+                if (strcmp(k.op, op) != 0) continue;
+                Stats st;
+                if (k.chase)
+                {
+                    if (!head) head = build_chains(b1, bytes, stride)[0];
+                    st = k.chase(head, iters);
+                }
+                else if (k.pass == nullptr) continue;
+                else if (strcmp(op, "copy") == 0)
+                    st = bw_gbs(k.pass, b2, b1, bytes, iters, threads, nullptr);
+                else
+                    st = bw_gbs(k.pass, b1, b1, bytes, iters, threads, nullptr);
+                res[i][t] = st.value;
+                record(string("tk.") + tiers[t].first + "." + k.name + (k.chase ? ".ns" : ".gbs"),
+                       st, k.chase ? "ns" : "GB/s", !k.chase);
+            }
+    }
+
+    cout << "Templated kernels (GB/s over the whole span, so .s64 counts every line touched;"
+         << " latency in ns" << (threads > 1 ? ", " + to_string(threads) +
+                                                         " threads" : string()) << ")\n";
+    cout << left << setw(24) << "kernel" << right;
+    for (const auto& t : tiers) cout << setw(11) << t.first;
+    cout << "\n";
+    for (size_t i = 0; i < ks.size(); ++i)
+    {
+        cout << left << setw(24) << ks[i]->name << right << fixed << setprecision(2);
+        for (double v : res[i]) cout << setw(11) << v;
+        cout << "\n";
+    }
+}
+
+//====================================================
+// Memory-level parallelism (interleaved chases)
+//====================================================
+// Walks K rings in lock-step: the K loads of one step are independent, so
+// the core can keep up to K misses in flight. Returns ns per access.
+template <int K>
+static double chase_ns(char* const* heads, uint64_t steps)
+{
+    char* p[K];
+    for (int k = 0; k < K; ++k) p[k] = heads[k];
+
+    for (int i = 0; i < 2000; ++i)
+        for (int k = 0; k < K; ++k) p[k] = *reinterpret_cast<char* volatile*>(p[k]);
+
+    uint64_t t0 = tnow();
+    for (uint64_t i = 0; i < steps; ++i)
+        for (int k = 0; k < K; ++k) p[k] = *reinterpret_cast<char* volatile*>(p[k]);
+    uint64_t t1 = tnow();
+
+    uint64_t s = 0;
+    for (int k = 0; k < K; ++k) s ^= (uint64_t)(uintptr_t)p[k];
+    sink64 ^= s;
+    double ns = tsec(t0, t1) * 1e9;
+    return ns / ((double)steps * K);
+}
+
+using ChaseFn = double (*)(char* const*, uint64_t);
+static const int kMaxChains = 32;
+
+template <size_t... I>
+static array<ChaseFn, sizeof...(I)> make_chase_table(index_sequence<I...>)
+{
+    return {{ &chase_ns<(int)I + 1>... }};
+}
+
+static const array<ChaseFn, kMaxChains> kChase = make_chase_table(make_index_sequence<kMaxChains>{});
+
+// For K = 1..maxChains: ns per access, the line bandwidth that implies, and
+// the misses in flight (Little's law: single-chain latency / per-access time).
+static void runMLP(char* buf, size_t KB, size_t stride, int maxChains)
+{
+    size_t bytes = KB * 1024ULL;
+    maxChains = max(1, min(maxChains, kMaxChains));
+    const uint64_t accesses = 1000000;
+
+    cout << "Memory-level parallelism (" << KB << " KB, stride " << stride << " B)\n";
+    cout << right << setw(8) << "chains" << setw(12) << "ns/access" << setw(10) << "GB/s"
+         << setw(14) << "in-flight" << "\n";
+
+    double base = 0, peak = 0;
+    for (int k = 1; k <= maxChains; ++k)
+    {
+        vector<char*> heads = build_chains(buf, bytes, stride, k);
+        double ns = kChase[k - 1](heads.data(), max<uint64_t>(1000, accesses / k));
+        if (k == 1) base = ns;
+        double inflight = base / ns;
+        peak = max(peak, inflight);
+        cout << setw(8) << k << fixed << setprecision(2) << setw(12) << ns
+             << setw(10) << kLine / ns << setw(14) << setprecision(1) << inflight << endl;
+        record("mlp.k" + to_string(k) + ".ns_per_access", ns, "ns", false);
+    }
+    cout << "Peak outstanding misses (LFB/MSHR estimate): " << fixed << setprecision(1)
+         << peak << "\n";
+    record("mlp.peak_inflight", peak, "misses", true);
+}
+
+//====================================================
+// STREAM kernels (--stream)
+//====================================================
+// Each pass splits its slice into equal arrays of doubles: a|b|c for the
+// four STREAM kernels, R source then W destination arrays for --rw. With
+// --threads every thread gets a whole tier-sized slice to itself.
+struct StreamConfig
+{
+    bool on = false;
+    vector<pair<int, int>> rw;      // R:W ratios for the mixed kernel
+};
+
+static StreamConfig g_stream;
+static const double kStreamScalar = 3.0;
+
+static double stream_copy_pass(char* dst, const char*, size_t bytes)
+{
+    size_t n = bytes / (3 * sizeof(double));
+    double* a = reinterpret_cast<double*>(dst);
+    double* c = a + 2 * n;
+    for (size_t i = 0; i < n; ++i) c[i] = a[i];
+    return n ? c[n - 1] : 0;
+}
+
+static double stream_scale_pass(char* dst, const char*, size_t bytes)
+{
+    size_t n = bytes / (3 * sizeof(double));
+    double* b = reinterpret_cast<double*>(dst) + n;
+    double* c = b + n;
+    for (size_t i = 0; i < n; ++i) b[i] = kStreamScalar * c[i];
+    return n ? b[n - 1] : 0;
+}
+
+static double stream_add_pass(char* dst, const char*, size_t bytes)
+{
+    size_t n = bytes / (3 * sizeof(double));
+    double* a = reinterpret_cast<double*>(dst);
+    double* b = a + n;
+    double* c = b + n;
+    for (size_t i = 0; i < n; ++i) c[i] = a[i] + b[i];
+    return n ? c[n - 1] : 0;
+}
+
+static double stream_triad_pass(char* dst, const char*, size_t bytes)
+{
+    size_t n = bytes / (3 * sizeof(double));
+    double* a = reinterpret_cast<double*>(dst);
+    double* b = a + n;
+    double* c = b + n;
+    for (size_t i = 0; i < n; ++i) a[i] = b[i] + kStreamScalar * c[i];
+    return n ? a[n - 1] : 0;
+}
+
+// R streams read, W streams written per element: out_w[i] = sum_r in_r[i] + w.
+template <int R, int W>
+static double rw_pass(char* dst, const char*, size_t bytes)
+{
+    size_t n = bytes / ((R + W) * sizeof(double));
+    double* in[R];
+    double* out[W];
+    for (int r = 0; r < R; ++r) in[r] = reinterpret_cast<double*>(dst) + r * n;
+    for (int w = 0; w < W; ++w) out[w] = reinterpret_cast<double*>(dst) + (R + w) * n;
+    for (size_t i = 0; i < n; ++i)
+    {
+        double s = 0;
+        for (int r = 0; r < R; ++r) s += in[r][i];
+        for (int w = 0; w < W; ++w) out[w][i] = s + w;
+    }
+    return n ? out[W - 1][n - 1] : 0;
+}
+
+static const int kMaxRw = 4;
+static const PassFn kRwPass[kMaxRw][kMaxRw] = {
+    { rw_pass<1, 1>, rw_pass<1, 2>, rw_pass<1, 3>, rw_pass<1, 4> },
+    { rw_pass<2, 1>, rw_pass<2, 2>, rw_pass<2, 3>, rw_pass<2, 4> },
+    { rw_pass<3, 1>, rw_pass<3, 2>, rw_pass<3, 3>, rw_pass<3, 4> },
+    { rw_pass<4, 1>, rw_pass<4, 2>, rw_pass<4, 3>, rw_pass<4, 4> },
+};
+
+// bw_gbs counts the whole slice once; STREAM counts only the arrays a
+// kernel touches, so Copy and Scale (2 of 3 arrays) are scaled by 2/3.
+// Write-allocate reads of the destination are not counted, as in STREAM.
+static Stats scale_stats(Stats s, double f)
+{
+    s.value *= f;
+    s.min *= f;
+    s.median *= f;
+    s.p95 *= f;
+    s.stddev *= f;
+    return s;
+}
+
+// Runs the four STREAM kernels and every --rw ratio over `KB` per thread.
+static void stream_tier(size_t KB, char* buf, int iters, int threads, Stats out[4],
+                        vector<Stats>& rw)
+{
+    size_t bytes = KB * 1024ULL * (size_t)max(1, threads);
+    const PassFn kernels[4] = { stream_copy_pass, stream_scale_pass, stream_add_pass,
+                                stream_triad_pass };
+    const double factor[4] = { 2.0 / 3.0, 2.0 / 3.0, 1.0, 1.0 };
+    // The buffer holds pointers from the latency rings, which read as
+    // denormals and would put Scale / Triad on the microcode assist path.
+    double* d = reinterpret_cast<double*>(buf);
+    fill(d, d + bytes / sizeof(double), 1.0);
+    for (int k = 0; k < 4; ++k)
+        out[k] = scale_stats(bw_gbs(kernels[k], buf, buf, bytes, iters, threads, nullptr),
+                             factor[k]);
+    rw.clear();
+    for (const auto& p : g_stream.rw)
+        rw.push_back(bw_gbs(kRwPass[p.first - 1][p.second - 1], buf, buf, bytes, iters,
+                            threads, nullptr));
+}
+
+//====================================================
+// Result row
+//====================================================
+struct Row 
+{
+    Stats 
+    r, 
+    w, 
+    wn,                             // write, streaming stores
+    c, 
+    cn,                             // copy, streaming stores
+    l;
+    vector<double> tr, tw, twn, tc, tcn; // per-thread GB/s (threads > 1)
+    PmcCounts pmc[6];               // --counters, per metric in r,w,wn,c,cn,l order
+    Stats stream[4];                // --stream Copy, Scale, Add, Triad
+    vector<Stats> rw;               // --stream, one per g_stream.rw ratio
+    RdtDelta rdt;                   // --rdt MBM / CMT over the whole tier
+};
+
+static const char* const kStreamNames[4] = { "Copy", "Scale", "Add", "Triad" };
+static const char* const kStreamKeys[4] = { "copy", "scale", "add", "triad" };
+
+static const char* const kRowMetrics[6] = { "read", "write", "writeNT", "copy", "copyNT", "latency" };
+
+static Row benchTier(const char* name,
+                     size_t KB,
+                     char* b1,
+                     char* b2,
+                     int iters,
+                     size_t stride,
+                     int threads) 
+{
+    size_t bytes = KB * 1024ULL;
+    Row x;
+    RdtSample r0 = rdt_sample();
+    auto t0 = clk::now();
+    x.pmc[0] = counted([&] { x.r = bw_read_gbs(b1, bytes, iters, threads, &x.tr); });
+    x.pmc[1] = counted([&] { x.w = bw_write_gbs(b1, bytes, iters, threads, &x.tw); });
+    x.pmc[2] = counted([&] { x.wn = bw_write_nt_gbs(b1, bytes, iters, threads, &x.twn); });
+    x.pmc[3] = counted([&] { x.c = bw_copy_gbs(b2, b1, bytes, iters, threads, &x.tc); });
+    x.pmc[4] = counted([&] { x.cn = bw_copy_nt_gbs(b2, b1, bytes, iters, threads, &x.tcn); });
+    // The shuffle and ring linking stay outside the counted region: only the
+    // chase derefs are in g_accesses.
+    char* head = build_chains(b1, bytes, stride)[0];
+    x.pmc[5] = counted([&] { x.l = chase_latency(head, iters); });
+    if (g_stream.on) stream_tier(KB, b1, iters, threads, x.stream, x.rw);
+    x.rdt = rdt_delta(r0, rdt_sample(), chrono::duration<double>(clk::now() - t0).count());
+    (void)name;
+    return x;
+}
+
+// v is in GB/s; values below 1 GB/s are shown in MB/s.
+static void fmt(double v) 
+{
+    bool gb = v >= 1.0;
+    double vv = gb ? v : v * 1000.0;
+    const char* u = gb ? "GB/s" : "MB/s";
+    cout << setw(8) << fixed << setprecision(2) << vv << " " << u;
+}
+
+// Median, with '*' marking a sample spread above kUnstableCV.
+static void fmt(const Stats& s) 
+{
+    fmt(s.value);
+    cout << (s.unstable ? '*' : ' ');
+}
+
+static void printRow(const char* label, const Row& x) 
+{
+    cout << left << setw(8) << label
+              << "  Read ";  fmt(x.r);
+    cout << "  Write "; fmt(x.w);
+    cout << "  WriteNT "; fmt(x.wn);
+    cout << "  Copy ";  fmt(x.c);
+    cout << "  CopyNT "; fmt(x.cn);
+    cout << "  Latency " << setw(6)
+              << fixed << setprecision(2) << x.l.value << " ns" << (x.l.unstable ? '*' : ' ');
+    if (g_timer.cpuGHz > 0) cout << " (" << setprecision(1) << x.l.value * g_timer.cpuGHz << " cyc)";
+    cout << "\n";
+    if (g_stream.on)
+    {
+        cout << left << setw(8) << "  stream";
+        for (int k = 0; k < 4; ++k)
+        {
+            cout << "  " << kStreamNames[k] << " ";
+            fmt(x.stream[k]);
+        }
+        for (size_t i = 0; i < x.rw.size() && i < g_stream.rw.size(); ++i)
+        {
+            cout << "  R" << g_stream.rw[i].first << ":W" << g_stream.rw[i].second << " ";
+            fmt(x.rw[i]);
+        }
+        cout << "\n";
+    }
+
+    const vector<int>& cpus = online_cpus();
+    for (size_t t = 0; t < x.tr.size(); ++t)
+    {
+        string tl = "  T" + to_string(t) + "@" + to_string(cpus[t % cpus.size()]);
+        cout << left << setw(8) << tl
+                  << "  Read ";  fmt(x.tr[t]);
+        cout << "   Write "; fmt(x.tw[t]);
+        cout << "   WriteNT "; fmt(x.twn[t]);
+        cout << "   Copy ";  fmt(x.tc[t]);
+        cout << "   CopyNT "; fmt(x.tcn[t]);
+        cout << " \n";
+    }
+}
+
+// --stats: one line per metric with the full sample summary.
+static void printStats(const char* label, const Row& x)
+{
+    const pair<const char*, const Stats*> m[] = {
+        { "read", &x.r }, { "write", &x.w }, { "writeNT", &x.wn },
+        { "copy", &x.c }, { "copyNT", &x.cn }, { "latency", &x.l } };
+    cout << left << setw(8) << label << right << setw(10) << "metric" << setw(11) << "min"
+         << setw(11) << "median" << setw(11) << "p95" << setw(11) << "stddev" << setw(7) << "n" << "\n";
+    for (const auto& e : m)
+    {
+        const char* unit = (e.second == &x.l) ? " ns" : " GB/s";
+        cout << left << setw(8) << "" << right << setw(10) << e.first << fixed << setprecision(2)
+             << setw(11) << e.second->min << setw(11) << e.second->median
+             << setw(11) << e.second->p95 << setw(11) << e.second->stddev
+             << setw(7) << e.second->n << unit << (e.second->unstable ? "  unstable" : "") << "\n";
+    }
+}
+
+// --counters: IPC and events per access (64 B line for bandwidth, deref for
+// latency) for each metric of the row; '-' where the event is unavailable.
+static void printCounters(const char* label, const Row& x)
+{
+    if (!x.pmc[0].valid) return;
+    cout << left << setw(8) << label << right << setw(10) << "counters" << setw(8) << "IPC"
+         << setw(10) << "L1D/acc" << setw(10) << "L2/acc" << setw(10) << "LLC/acc"
+         << setw(10) << "DTLB/acc" << setw(12) << "DRAM B/acc" << "\n";
+    for (int m = 0; m < 6; ++m)
+    {
+        const PmcCounts& c = x.pmc[m];
+        auto cell = [&](int w, bool have, double v)
+        {
+            if (have) cout << setw(w) << fixed << setprecision(3) << v;
+            else cout << setw(w) << "-";
+        };
+        cout << left << setw(8) << "" << right << setw(10) << kRowMetrics[m];
+        cell(8, c.have[PmcCycles] && c.have[PmcInstr] && c.v[PmcCycles] > 0,
+             c.v[PmcCycles] > 0 ? c.v[PmcInstr] / c.v[PmcCycles] : 0);
+        cell(10, c.have[PmcL1dMiss], c.v[PmcL1dMiss]);
+        cell(10, c.have[PmcL2Miss], c.v[PmcL2Miss]);
+        cell(10, c.have[PmcLlcMiss], c.v[PmcLlcMiss]);
+        cell(10, c.have[PmcDtlbMiss], c.v[PmcDtlbMiss]);
+        cell(12, c.have[PmcDramBytes], c.v[PmcDramBytes]);
+        cout << "\n";
+    }
+}
+
+// --rdt: the resctrl group's memory bandwidth (MBM) over the tier and its
+// LLC occupancy (CMT) at the end; '-' where the counter is unavailable.
+static void printRdt(const char* label, const Row& x)
+{
+    if (!x.rdt.valid) return;
+    auto cell = [](double v, const char* unit)
+    {
+        if (v < 0) cout << setw(9) << "-" << " " << unit;
+        else cout << setw(9) << fixed << setprecision(2) << v << " " << unit;
+    };
+    cout << left << setw(8) << label << "  rdt  MBM total ";
+    cell(x.rdt.totalGBs, "GB/s");
+    cout << "  local ";
+    cell(x.rdt.localGBs, "GB/s");
+    cout << "  LLC occupancy ";
+    cell(x.rdt.occMB, "MB");
+    cout << "\n";
+}
+
+static void recordRdt(const string& label, const RdtDelta& d)
+{
+    if (!d.valid) return;
+    if (d.totalGBs >= 0) record(label + ".rdt.mbm_total_gbs", d.totalGBs, "GB/s", true);
+    if (d.localGBs >= 0) record(label + ".rdt.mbm_local_gbs", d.localGBs, "GB/s", true);
+    if (d.occMB >= 0) record(label + ".rdt.llc_occupancy_mb", d.occMB, "MB", true);
+}
+
+static void recordRow(const string& label, const Row& x)
+{
+    recordRdt(label, x.rdt);
+    for (int m = 0; m < 6; ++m)
+    {
+        const PmcCounts& c = x.pmc[m];
+        if (!c.valid) continue;
+        for (int i = 0; i < kNumPmc; ++i)
+            if (c.have[i])
+                record(label + "." + kRowMetrics[m] + "." + kPmcNames[i] + "_per_access", c.v[i],
+                       "count", false);
+    }
+    record(label + ".read_gbs", x.r, "GB/s", true);
+    record(label + ".write_gbs", x.w, "GB/s", true);
+    record(label + ".write_nt_gbs", x.wn, "GB/s", true);
+    record(label + ".copy_gbs", x.c, "GB/s", true);
+    record(label + ".copy_nt_gbs", x.cn, "GB/s", true);
+    record(label + ".latency_ns", x.l, "ns", false);
+    if (!g_stream.on) return;
+    for (int k = 0; k < 4; ++k)
+        record(label + ".stream_" + kStreamKeys[k] + "_gbs", x.stream[k], "GB/s", true);
+    for (size_t i = 0; i < x.rw.size() && i < g_stream.rw.size(); ++i)
+        record(label + ".rw" + to_string(g_stream.rw[i].first) + "_" +
+               to_string(g_stream.rw[i].second) + "_gbs", x.rw[i], "GB/s", true);
+}
+
+static bool anyUnstable(const Row& x)
+{
+    return x.r.unstable || x.w.unstable || x.wn.unstable || x.c.unstable ||
+           x.cn.unstable || x.l.unstable;
+}
+
+//====================================================
+// Working-set sweep
+//====================================================
+// Log-spaced sizes from minKB to maxKB with `ppo` points per octave.
+static vector<size_t> sweep_sizes_kb(size_t minKB, size_t maxKB, int ppo)
+{
+    vector<size_t> v;
+    for (int i = 0;; ++i)
+    {
+        double kb = (double)minKB * pow(2.0, (double)i / ppo);
+        if (kb > (double)maxKB * 1.0001) break;
+        size_t k = (size_t)llround(kb);
+        if (v.empty() || k != v.back()) v.push_back(k);
+    }
+    return v;
+}
+
+// Prints a whitespace-separated table (gnuplot / pandas friendly) with one
+// benchTier run per size; rows are flushed as they complete.
+static void runSweep(char* b1, char* b2, size_t minKB, size_t maxKB, int ppo,
+                     int iters, size_t stride, int threads)
+{
+    vector<size_t> sizes = sweep_sizes_kb(minKB, maxKB, ppo);
+    cout << "# Working-set sweep: " << minKB << " KB .. " << maxKB << " KB, "
+         << ppo << " points/octave\n";
+    cout << "# " << right << setw(10) << "size_KB" << setw(12) << "latency_ns"
+         << setw(11) << "read_GBs" << setw(11) << "write_GBs" << setw(13) << "writent_GBs"
+         << setw(11) << "copy_GBs" << setw(12) << "copynt_GBs" << "\n";
+    for (size_t kb : sizes)
+    {
+        Row x = benchTier("sweep", kb, b1, b2, iters, stride, threads);
+        cout << "  " << right << setw(10) << kb << fixed << setprecision(2)
+             << setw(12) << x.l.value << setw(11) << x.r.value << setw(11) << x.w.value
+             << setw(13) << x.wn.value << setw(11) << x.c.value << setw(12) << x.cn.value << endl;
+        recordRow("sweep." + to_string(kb) + "KB", x);
+    }
+}
+
+//====================================================
+// NUMA placement matrix (--numa)
+//====================================================
+struct NumaNode
+{
+    int id;
+    vector<int> cpus;               // allowed CPUs on this node
+};
+
+// Parses sysfs CPU/node lists such as "0-3,8-11".
+static vector<int> parse_list(const string& s)
+{
+    vector<int> v;
+    size_t i = 0;
+    while (i < s.size())
+    {
+        size_t end = s.find(',', i);
+        if (end == string::npos) end = s.size();
+        string part = s.substr(i, end - i);
+        size_t dash = part.find('-');
+        if (!part.empty())
+        {
+            int lo = atoi(part.c_str());
+            int hi = (dash == string::npos) ? lo : atoi(part.c_str() + dash + 1);
+            for (int c = lo; c <= hi; ++c) v.push_back(c);
+        }
+        i = end + 1;
+    }
+    return v;
+}
+
+static vector<NumaNode> numa_nodes()
+{
+    vector<NumaNode> nodes;
+#if defined(__linux__)
+    const vector<int>& allowed = online_cpus();
+    for (int id : parse_list(read_text("/sys/devices/system/node/online")))
+    {
+        NumaNode n{ id, {} };
+        for (int c : parse_list(read_text("/sys/devices/system/node/node" + to_string(id) + "/cpulist")))
+            if (find(allowed.begin(), allowed.end(), c) != allowed.end()) n.cpus.push_back(c);
+        nodes.push_back(n);
+    }
+#endif
+    return nodes;
+}
+
+#if defined(__linux__)
+// Binds [p, p+bytes) to `node` (MPOL_BIND) before first touch; raw syscalls
+// keep libnuma out of the build.
+static bool bind_to_node(char* p, size_t bytes, int node)
+{
+    const unsigned long MPOL_BIND_ = 2, MPOL_MF_STRICT_ = 1, MPOL_MF_MOVE_ = 2;
+    unsigned long mask[16] = {};
+    if (node < 0 || node >= (int)(sizeof(mask) * 8)) return false;
+    mask[node / 64] |= 1UL << (node % 64);
+    return syscall(SYS_mbind, p, bytes, MPOL_BIND_, mask, sizeof(mask) * 8,
+                   MPOL_MF_STRICT_ | MPOL_MF_MOVE_) == 0;
+}
+
+// Node holding the page at p (move_pages with no destination only queries).
+static int node_of(char* p)
+{
+    void* pages[1] = { p };
+    int status[1] = { -1 };
+    if (syscall(SYS_move_pages, 0, 1UL, pages, nullptr, status, 0) != 0) return -1;
+    return status[0];
+}
+#endif
+
+// Runs fn on a thread pinned to `cpu` and waits for it.
+template <typename F>
+static void run_on_cpu(int cpu, F fn)
+{
+    thread t([&] { pin_thread(cpu); fn(); });
+    t.join();
+}
+
+// For every memory node M, binds two buffers to M, then measures latency and
+// single-thread read/write/copy from a thread on every CPU node N.
+static void runNuma(size_t KB, size_t stride, int iters, PageKind pages)
+{
+#if defined(__linux__)
+    vector<NumaNode> nodes = numa_nodes();
+    vector<NumaNode> cpuNodes;
+    for (const NumaNode& n : nodes)
+        if (!n.cpus.empty()) cpuNodes.push_back(n);
+    if (nodes.empty() || cpuNodes.empty())
+    {
+        cerr << "NUMA: no nodes found in /sys/devices/system/node\n";
+        return;
+    }
+    if (pages == PageKind::Default) pages = PageKind::Small;
+
+    size_t bytes = KB * 1024ULL;
+    size_t rows = cpuNodes.size(), cols = nodes.size();
+    vector<double> lat(rows * cols), rd(rows * cols), wr(rows * cols), cp(rows * cols);
+    vector<bool> ok(cols, false);
+
+    for (size_t m = 0; m < cols; ++m)
+    {
+        Buffer a = alloc_buffer(bytes + (1ULL << 21), pages);
+        Buffer b = alloc_buffer(bytes + (1ULL << 21), pages);
+        if (!a.p || !b.p || !bind_to_node(a.p, a.bytes, nodes[m].id) ||
+            !bind_to_node(b.p, b.bytes, nodes[m].id))
+        {
+            cerr << "NUMA: cannot bind memory to node " << nodes[m].id << "\n";
+            free_buffer(a);
+            free_buffer(b);
+            continue;
+        }
+        for (size_t off = 0; off < a.bytes; off += 4096)
+        {
+            a.p[off] = 1;
+            b.p[off] = 2;
+        }
+        int got = node_of(a.p);
+        if (got >= 0 && got != nodes[m].id)
+            cerr << "NUMA: node " << nodes[m].id << " buffer landed on node " << got << "\n";
+        ok[m] = true;
+
+        for (size_t n = 0; n < rows; ++n)
+        {
+            run_on_cpu(cpuNodes[n].cpus[0], [&]
+            {
+                size_t i = n * cols + m;
+                lat[i] = latency_ns(a.p, bytes, stride, iters).value;
+                rd[i] = bw_read_gbs(a.p, bytes, iters).value;
+                wr[i] = bw_write_gbs(a.p, bytes, iters).value;
+                cp[i] = bw_copy_gbs(b.p, a.p, bytes, iters).value;
+            });
+        }
+        free_buffer(a);
+        free_buffer(b);
+    }
+
+    cout << "NUMA matrix (" << KB << " KB per buffer; rows = CPU node, columns = memory node)\n";
+    auto table = [&](const char* title, const vector<double>& v)
+    {
+        cout << title << "\n" << left << setw(8) << "";
+        for (size_t m = 0; m < cols; ++m) cout << right << setw(10) << ("mem" + to_string(nodes[m].id));
+        cout << "\n";
+        for (size_t n = 0; n < rows; ++n)
+        {
+            cout << left << setw(8) << ("cpu" + to_string(cpuNodes[n].id));
+            for (size_t m = 0; m < cols; ++m)
+            {
+                if (ok[m]) cout << right << setw(10) << fixed << setprecision(2) << v[n * cols + m];
+                else cout << right << setw(10) << "-";
+            }
+            cout << "\n";
+        }
+    };
+    table("Latency (ns)", lat);
+    table("Read (GB/s)", rd);
+    table("Write (GB/s)", wr);
+    table("Copy (GB/s)", cp);
+
+    for (size_t n = 0; n < rows; ++n)
+    {
+        for (size_t m = 0; m < cols; ++m)
+        {
+            if (!ok[m]) continue;
+            string key = "numa.cpu" + to_string(cpuNodes[n].id) + ".mem" + to_string(nodes[m].id);
+            size_t i = n * cols + m;
+            record(key + ".latency_ns", lat[i], "ns", false);
+            record(key + ".read_gbs", rd[i], "GB/s", true);
+            record(key + ".write_gbs", wr[i], "GB/s", true);
+            record(key + ".copy_gbs", cp[i], "GB/s", true);
+        }
+    }
+#else
+    (void)KB; (void)stride; (void)iters; (void)pages;
+    cerr << "NUMA mode is only supported on Linux\n";
+#endif
+}
+
+//====================================================
+// Loaded latency (--loaded)
+//====================================================
+// Intel MLC style: one pinned thread chases a random ring over the Memory
+// tier while the other threads stream read/write/copy traffic. After every
+// 1 KB chunk a traffic thread spins `delay` pause instructions, so larger
+// delays inject less load. Each delay yields one point on the
+// latency-vs-delivered-bandwidth curve.
+struct alignas(64) PaddedCounter
+{
+    atomic<uint64_t> v{0};
+};
+
+static vector<int> parse_int_list(const string& s)
+{
+    vector<int> v;
+    size_t i = 0;
+    while (i < s.size())
+    {
+        size_t end = s.find(',', i);
+        if (end == string::npos) end = s.size();
+        if (end > i) v.push_back(atoi(s.substr(i, end - i).c_str()));
+        i = end + 1;
+    }
+    return v;
+}
+
+static void runLoaded(char* chaseBuf, char* trafficBuf, size_t KB, size_t stride, int iters,
+                      int trafficThreads, const string& traffic, const vector<int>& delays)
+{
+    const vector<int>& cpus = online_cpus();
+    if (trafficThreads <= 0) trafficThreads = max(1, (int)cpus.size() - 1);
+    PassFn pass = (traffic == "write") ? g_kernel->write
+                : (traffic == "copy")  ? copy_pass
+                                       : g_kernel->read;
+    const size_t chunk = 1024;
+    size_t bytes = KB * 1024ULL;
+    size_t slice = (bytes / trafficThreads) & ~(chunk - 1);
+    size_t half = (slice / 2) & ~(chunk - 1);
+    if (slice < 2 * chunk)
+    {
+        cerr << "loaded: Memory tier too small for " << trafficThreads << " traffic threads\n";
+        return;
+    }
+
+    char* head = build_chains(chaseBuf, bytes, stride)[0];
+    Stats idle;
+    run_on_cpu(cpus[0], [&] { idle = chase_latency(head, iters); });
+
+    cout << "Loaded latency (" << KB << " KB, " << trafficThreads << " " << traffic
+         << " threads, chaser on CPU " << cpus[0] << ")\n";
+    cout << right << setw(8) << "delay" << setw(12) << "bw_GBs" << setw(12) << "lat_ns"
+         << setw(12) << "p95_ns" << "\n";
+    cout << setw(8) << "idle" << fixed << setprecision(2) << setw(12) << 0.0 << setw(12)
+         << idle.value << setw(12) << idle.p95 << "\n";
+    record("loaded.idle.latency_ns", idle, "ns", false);
+
+    for (int delay : delays)
+    {
+        atomic<bool> stop{false};
+        vector<PaddedCounter> moved(trafficThreads);
+        vector<uint64_t> sinks(trafficThreads);
+        vector<thread> pool;
+        for (int t = 0; t < trafficThreads; ++t)
+        {
+            pool.emplace_back([&, t]
+            {
+                pin_thread(cpus[(t + 1) % cpus.size()]);
+                char* base = trafficBuf + t * slice;
+                char* src = (traffic == "copy") ? base + half : base;
+                size_t span = (traffic == "copy") ? half : slice;
+                uint64_t local = 0;
+                while (!stop.load(memory_order_relaxed))
+                {
+                    for (size_t off = 0; off + chunk <= span; off += chunk)
+                    {
+                        local ^= (uint64_t)pass(base + off, src + off, chunk);
+                        for (int d = 0; d < delay; ++d) cpu_relax();
+                        moved[t].v.fetch_add(traffic == "copy" ? 2 * chunk : chunk,
+                                             memory_order_relaxed);
+                        if (stop.load(memory_order_relaxed)) break;
+                    }
+                }
+                sinks[t] = local;
+            });
+        }
+
+        Stats lat;
+        uint64_t b0 = 0, b1 = 0;
+        double sec = 0;
+        run_on_cpu(cpus[0], [&]
+        {
+            this_thread::sleep_for(chrono::milliseconds(10)); // let traffic ramp up
+            for (auto& m : moved) b0 += m.v.load(memory_order_relaxed);
+            uint64_t t0 = tnow();
+            lat = chase_latency(head, iters);
+            sec = tsec(t0, tnow());
+            for (auto& m : moved) b1 += m.v.load(memory_order_relaxed);
+        });
+        stop.store(true);
+        for (auto& th : pool) th.join();
+        for (uint64_t v : sinks) sink64 ^= v;
+
+        double gbs = sec > 0 ? (double)(b1 - b0) / sec / 1e9 : 0;
+        cout << setw(8) << delay << fixed << setprecision(2) << setw(12) << gbs << setw(12)
+             << lat.value << setw(12) << lat.p95 << endl;
+        string key = "loaded.d" + to_string(delay);
+        record(key + ".bw_gbs", gbs, "GB/s", true);
+        record(key + ".latency_ns", lat, "ns", false);
+    }
+}
+
+//====================================================
+// Access-pattern library (--patterns)
+//====================================================
+// Read and write kernels over one tier buffer with a chosen address stream:
+//   seq     every 8-byte element in order (the kernel set's own pass)
+//   strideN one element every N bytes
+//   random  one element per cache line, lines in shuffled order
+//   page    unaligned 8-byte accesses straddling every 4 KB page boundary
+//   gather  index vector of random elements; AVX2/AVX-512 vpgather/vpscatter
+//           when the selected kernel set has them
+// Results are useful bytes/s (only the bytes the pattern asks for) and
+// cache lines touched per second.
+struct PatternPlan
+{
+    string name;
+    size_t accesses = 0;            // 8-byte accesses per pass
+    size_t lines = 0;               // cache lines touched per pass
+    vector<uint32_t> idx;           // element indices (random / gather)
+    size_t stride = 0;              // bytes between accesses (stride / page)
+};
+
+static double pat_read_stride(const char* p, size_t bytes, size_t stride)
+{
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    size_t i = 0;
+    for (; i + 4 * stride <= bytes; i += 4 * stride)
+    {
+        a0 += *reinterpret_cast<const uint64_t*>(p + i);
+        a1 += *reinterpret_cast<const uint64_t*>(p + i + stride);
+        a2 += *reinterpret_cast<const uint64_t*>(p + i + 2 * stride);
+        a3 += *reinterpret_cast<const uint64_t*>(p + i + 3 * stride);
+    }
+    for (; i + sizeof(uint64_t) <= bytes; i += stride) a0 += *reinterpret_cast<const uint64_t*>(p + i);
+    return (double)(a0 ^ a1 ^ a2 ^ a3);
+}
+
+static double pat_write_stride(char* p, size_t bytes, size_t stride)
+{
+    for (size_t i = 0; i + sizeof(uint64_t) <= bytes; i += stride)
+        *reinterpret_cast<uint64_t*>(p + i) = i;
+    return 0;
+}
+
+// One unaligned load/store of 8 bytes, 4 on each side of a page boundary.
+static double pat_read_page(const char* p, size_t bytes)
+{
+    uint64_t a = 0;
+    for (size_t i = 4096; i + 4 <= bytes; i += 4096)
+    {
+        uint64_t v;
+        memcpy(&v, p + i - 4, sizeof(v));
+        a += v;
+    }
+    return (double)a;
+}
+
+static double pat_write_page(char* p, size_t bytes)
+{
+    for (size_t i = 4096; i + 4 <= bytes; i += 4096)
+    {
+        uint64_t v = i;
+        memcpy(p + i - 4, &v, sizeof(v));
+    }
+    return 0;
+}
+
+static double pat_read_index(const char* p, const vector<uint32_t>& idx)
+{
+    auto* e = reinterpret_cast<const uint64_t*>(p);
+    uint64_t a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    size_t n = idx.size(), i = 0;
+    for (; i + 4 <= n; i += 4)
+    {
+        a0 += e[idx[i]];
+        a1 += e[idx[i + 1]];
+        a2 += e[idx[i + 2]];
+        a3 += e[idx[i + 3]];
+    }
+    for (; i < n; ++i) a0 += e[idx[i]];
+    return (double)(a0 ^ a1 ^ a2 ^ a3);
+}
+
+static double pat_write_index(char* p, const vector<uint32_t>& idx)
+{
+    auto* e = reinterpret_cast<uint64_t*>(p);
+    for (size_t i = 0; i < idx.size(); ++i) e[idx[i]] = i;
+    return 0;
+}
+
+#if defined(CB_X86)
+__attribute__((target("avx2")))
+static double pat_gather_avx2(const char* p, const vector<uint32_t>& idx)
+{
+    auto* base = reinterpret_cast<const long long*>(p);
+    __m256i a0 = _mm256_setzero_si256(), a1 = a0;
+    size_t n = idx.size(), i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m128i v0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&idx[i]));
+        __m128i v1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&idx[i + 4]));
+        a0 = _mm256_add_epi64(a0, _mm256_i32gather_epi64(base, v0, 8));
+        a1 = _mm256_add_epi64(a1, _mm256_i32gather_epi64(base, v1, 8));
+    }
+    uint64_t lanes[4];
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(lanes), _mm256_add_epi64(a0, a1));
+    uint64_t r = lanes[0] ^ lanes[1] ^ lanes[2] ^ lanes[3];
+    for (; i < n; ++i) r += (uint64_t)base[idx[i]];
+    return (double)r;
+}
+
+__attribute__((target("avx512f")))
+static double pat_gather_avx512(const char* p, const vector<uint32_t>& idx)
+{
+    auto* base = reinterpret_cast<const long long*>(p);
+    // Masked form with an explicit zero source: the unmasked intrinsic trips
+    // a GCC 12 -Wmaybe-uninitialized false positive.
+    const __m512i zero = _mm512_setzero_si512();
+    __m512i a0 = zero, a1 = zero;
+    size_t n = idx.size(), i = 0;
+    for (; i + 16 <= n; i += 16)
+    {
+        __m256i v0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&idx[i]));
+        __m256i v1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&idx[i + 8]));
+        a0 = _mm512_add_epi64(a0, _mm512_mask_i32gather_epi64(zero, 0xFF, v0, base, 8));
+        a1 = _mm512_add_epi64(a1, _mm512_mask_i32gather_epi64(zero, 0xFF, v1, base, 8));
+    }
+    uint64_t lanes[8];
+    _mm512_storeu_si512(lanes, _mm512_add_epi64(a0, a1));
+    uint64_t r = 0;
+    for (uint64_t v : lanes) r ^= v;
+    for (; i < n; ++i) r += (uint64_t)base[idx[i]];
+    return (double)r;
+}
+
+__attribute__((target("avx512f")))
+static double pat_scatter_avx512(char* p, const vector<uint32_t>& idx)
+{
+    auto* base = reinterpret_cast<long long*>(p);
+    const __m512i v = _mm512_set1_epi64(0x0101010101010101LL);
+    size_t n = idx.size(), i = 0;
+    for (; i + 8 <= n; i += 8)
+    {
+        __m256i vi = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(&idx[i]));
+        _mm512_i32scatter_epi64(base, vi, v, 8);
+    }
+    for (; i < n; ++i) base[idx[i]] = 0x0101010101010101LL;
+    return 0;
+}
+#endif
+
+static vector<PatternPlan> make_patterns(size_t bytes, size_t stride)
+{
+    vector<PatternPlan> v;
+    size_t lines = bytes / kLine;
+    size_t elems = bytes / sizeof(uint64_t);
+    mt19937_64 rng(7654321);
+
+    PatternPlan seq;
+    seq.name = "seq";
+    seq.accesses = elems;
+    seq.lines = lines;
+    v.push_back(seq);
+
+    PatternPlan st;
+    st.name = "stride" + to_string(stride);
+    st.stride = stride;
+    st.accesses = (bytes - sizeof(uint64_t)) / stride + 1;
+    st.lines = stride >= kLine ? st.accesses : lines;
+    v.push_back(st);
+
+    PatternPlan rnd;
+    rnd.name = "random";
+    rnd.idx.resize(lines);
+    for (size_t i = 0; i < lines; ++i) rnd.idx[i] = (uint32_t)(i * (kLine / sizeof(uint64_t)));
+    shuffle(rnd.idx.begin(), rnd.idx.end(), rng);
+    rnd.accesses = rnd.lines = lines;
+    v.push_back(rnd);
+
+    PatternPlan pg;
+    pg.name = "page";
+    pg.stride = 4096;
+    pg.accesses = bytes >= 4100 ? (bytes - 4) / 4096 : 0;
+    pg.lines = 2 * pg.accesses;
+    if (pg.accesses) v.push_back(pg);
+
+    PatternPlan g;
+    g.name = "gather";
+    g.idx.resize(lines);
+    uniform_int_distribution<uint32_t> pick(0, (uint32_t)(elems - 1));
+    for (auto& x : g.idx) x = pick(rng);
+    g.accesses = g.lines = lines;
+    v.push_back(g);
+    return v;
+}
+
+static void runPatterns(char* buf, const vector<pair<const char*, size_t>>& tiers, size_t stride,
+                        int iters)
+{
+    bool avx512 = !strcmp(g_kernel->name, "avx512");
+    bool avx2 = avx512 || !strcmp(g_kernel->name, "avx2");
+    const char* gatherIsa = avx512 ? "avx512" : avx2 ? "avx2" : "scalar";
+
+    cout << "Access patterns (useful GB/s and M lines/s; gather uses " << gatherIsa << ")\n";
+    cout << left << setw(8) << "Tier" << setw(12) << "pattern" << right << setw(11) << "read_GBs"
+         << setw(12) << "read_Mln/s" << setw(11) << "write_GBs" << setw(12) << "write_Mln/s" << "\n";
+    for (const auto& t : tiers)
+    {
+        size_t bytes = t.second * 1024ULL;
+        for (const PatternPlan& pl : make_patterns(bytes, stride))
+        {
+            function<double()> rd, wr;
+            if (pl.name == "seq")
+            {
+                rd = [&] { return g_kernel->read(buf, buf, bytes); };
+                wr = [&] { return g_kernel->write(buf, buf, bytes); };
+            }
+            else if (pl.stride && pl.name != "page")
+            {
+                rd = [&] { return pat_read_stride(buf, bytes, pl.stride); };
+                wr = [&] { return pat_write_stride(buf, bytes, pl.stride); };
+            }
+            else if (pl.name == "page")
+            {
+                rd = [&] { return pat_read_page(buf, bytes); };
+                wr = [&] { return pat_write_page(buf, bytes); };
+            }
+            else
+            {
+                rd = [&] { return pat_read_index(buf, pl.idx); };
+                wr = [&] { return pat_write_index(buf, pl.idx); };
+#if defined(CB_X86)
+                if (pl.name == "gather" && avx512)
+                {
+                    rd = [&] { return pat_gather_avx512(buf, pl.idx); };
+                    wr = [&] { return pat_scatter_avx512(buf, pl.idx); };
+                }
+                else if (pl.name == "gather" && avx2)
+                {
+                    rd = [&] { return pat_gather_avx2(buf, pl.idx); };
+                }
+#endif
+            }
+
+            Stats r = run_reps(rd, iters).stats([&](double sec) { return pl.accesses * 8.0 / sec / 1e9; });
+            Stats w = run_reps(wr, iters).stats([&](double sec) { return pl.accesses * 8.0 / sec / 1e9; });
+            double perByte = (double)pl.lines / (pl.accesses * 8.0);  // lines per useful byte
+            cout << left << setw(8) << t.first << setw(12) << pl.name << right << fixed
+                 << setprecision(2) << setw(11) << r.value << setw(12) << r.value * perByte * 1e3
+                 << setw(11) << w.value << setw(12) << w.value * perByte * 1e3 << endl;
+
+            string key = string("pattern.") + t.first + "." + pl.name;
+            record(key + ".read_gbs", r, "GB/s", true);
+            record(key + ".write_gbs", w, "GB/s", true);
+            record(key + ".read_mlines", r.value * perByte * 1e3, "Mlines/s", true);
+            record(key + ".write_mlines", w.value * perByte * 1e3, "Mlines/s", true);
+        }
+    }
+}
+
+//====================================================
+// Prefetcher characterization (--prefetch)
+//====================================================
+// latency_ns() shuffles its nodes to defeat the hardware prefetchers and the
+// bandwidth passes are purely sequential; this suite measures what lies in
+// between, over the Memory tier:
+//   stride walks   dependent chase in address order, forward and backward, at
+//                  64 B .. 8 KB strides (where does the stride prefetcher give up?)
+//   page-local     lines in order inside each 4 KB page, pages shuffled
+//                  (cost of restarting the stream at every page boundary)
+//   streams        K sequential rings walked in lock-step (how many streams can
+//                  the prefetcher track at once?)
+//   sw prefetch    random-line probes whose addresses are known ahead (like
+//                  B-tree / hash-table lookups from a key batch), each probe
+//                  dependent on the previous one, with __builtin_prefetch
+//                  issued D probes ahead
+
+// Links the nodes at the given byte offsets into one ring, in order.
+static char* link_ring(char* buf, const vector<size_t>& offs)
+{
+    for (size_t i = 0; i < offs.size(); ++i)
+        *reinterpret_cast<char**>(buf + offs[i]) = buf + offs[(i + 1) % offs.size()];
+    return buf + offs[0];
+}
+
+static vector<size_t> stride_offsets(size_t base, size_t bytes, size_t stride, bool backward)
+{
+    vector<size_t> offs;
+    for (size_t o = 0; o + sizeof(void*) <= bytes; o += stride) offs.push_back(base + o);
+    if (backward) reverse(offs.begin(), offs.end());
+    return offs;
+}
+
+// One probe per entry of `lines`; the address of probe i+1 also depends on the
+// value loaded by probe i (always 0), so the probes serialise like a lookup
+// chain while their addresses stay computable for the prefetch. The prefetch
+// address carries the same dependency, otherwise out-of-order execution would
+// run the prefetches arbitrarily far ahead and hide the distance. `lines`
+// carries `dist` extra entries at the end so the prefetch index never wraps.
+static double probe_pass(const char* buf, const vector<uint32_t>& lines, size_t probes, int dist)
+{
+    uint64_t v = 0;
+    for (size_t i = 0; i < probes; ++i)
+    {
+        if (dist) __builtin_prefetch(buf + (size_t)lines[i + dist] * kLine + v);
+        v += *reinterpret_cast<const volatile uint64_t*>(buf + (size_t)lines[i] * kLine + v);
+    }
+    return (double)v;
+}
+
+static void runPrefetch(char* buf, size_t KB, int iters, const vector<int>& dists)
+{
+    size_t bytes = KB * 1024ULL;
+    const size_t kPage = 4096;
+    if (bytes < kPage)              // the page-local ring needs one whole page
+    {
+        cerr << "--prefetchKB must be at least " << kPage / 1024 << "\n";
+        return;
+    }
+    cout << "Prefetcher characterization (" << KB << " KB, dependent loads, ns/access)\n";
+
+    Stats rnd = latency_ns(buf, bytes, kLine, iters);
+    cout << "Random lines (prefetch-proof baseline): " << fixed << setprecision(2)
+         << rnd.value << " ns\n";
+    record("prefetch.random.ns", rnd, "ns", false);
+
+    cout << right << setw(8) << "stride" << setw(12) << "forward" << setw(12) << "backward" << "\n";
+    for (size_t s = kLine; s <= 8192; s *= 2)
+    {
+        Stats f = chase_latency(link_ring(buf, stride_offsets(0, bytes, s, false)), iters);
+        Stats b = chase_latency(link_ring(buf, stride_offsets(0, bytes, s, true)), iters);
+        cout << setw(8) << s << fixed << setprecision(2) << setw(12) << f.value
+             << setw(12) << b.value << endl;
+        string key = "prefetch.stride" + to_string(s);
+        record(key + ".fwd_ns", f, "ns", false);
+        record(key + ".bwd_ns", b, "ns", false);
+    }
+
+    {
+        vector<size_t> pages(bytes / kPage);
+        for (size_t i = 0; i < pages.size(); ++i) pages[i] = i;
+        mt19937_64 rng(1234567);
+        shuffle(pages.begin(), pages.end(), rng);
+        vector<size_t> offs;
+        for (size_t pg : pages)
+            for (size_t o = 0; o < kPage; o += kLine) offs.push_back(pg * kPage + o);
+        Stats pl = chase_latency(link_ring(buf, offs), iters);
+        cout << "Page-local (lines in order, 4 KB pages shuffled): " << fixed << setprecision(2)
+             << pl.value << " ns\n";
+        record("prefetch.page_local.ns", pl, "ns", false);
+    }
+
+    cout << "Concurrent sequential streams (64 B stride, lock-step)\n";
+    cout << setw(8) << "streams" << setw(12) << "ns/access" << setw(10) << "GB/s" << "\n";
+    for (int k = 1; k <= kMaxChains; k *= 2)
+    {
+        size_t region = (bytes / k) & ~(kPage - 1);
+        if (region < kPage) break;      // fewer pages than streams
+        vector<char*> heads;
+        for (int j = 0; j < k; ++j)
+            heads.push_back(link_ring(buf, stride_offsets(j * region, region, kLine, false)));
+        uint64_t steps = max<uint64_t>(1000, min<uint64_t>(2000000 / k, region / kLine));
+        double ns = kChase[k - 1](heads.data(), steps);
+        cout << setw(8) << k << fixed << setprecision(2) << setw(12) << ns
+             << setw(10) << kLine / ns << endl;
+        record("prefetch.streams" + to_string(k) + ".ns_per_access", ns, "ns", false);
+    }
+
+    // Probe targets: random lines; offset 0 of each one is zeroed so the
+    // dependent offset `v` stays 0.
+    size_t nLines = bytes / kLine;
+    size_t probes = min<size_t>(nLines, 1 << 18);
+    int maxDist = 0;
+    for (int d : dists) maxDist = max(maxDist, d);
+    if (dists.empty() || *min_element(dists.begin(), dists.end()) < 0)
+    {
+        cerr << "--prefetch-dists needs non-negative distances\n";
+        return;
+    }
+    vector<uint32_t> lines(probes + maxDist);
+    mt19937_64 rng(7654321);
+    for (auto& l : lines) l = (uint32_t)(rng() % nLines);
+    for (uint32_t l : lines) *reinterpret_cast<uint64_t*>(buf + (size_t)l * kLine) = 0;
+
+    cout << "Software prefetch on random probes\n";
+    cout << setw(8) << "distance" << setw(12) << "ns/probe" << setw(10) << "speedup" << "\n";
+    double none = 0;
+    for (int d : dists)
+    {
+        Stats s = run_reps([&] { return probe_pass(buf, lines, probes, d); }, iters)
+                      .stats([&](double sec) { return sec * 1e9 / (double)probes; });
+        if (none == 0) none = s.value;
+        cout << setw(8) << d << fixed << setprecision(2) << setw(12) << s.value
+             << setw(10) << none / s.value << endl;
+        record("prefetch.sw_dist" + to_string(d) + ".ns", s, "ns", false);
+    }
+}
+
+//====================================================
+// Core-to-core coherence and false sharing (--c2c)
+//====================================================
+// Three views of cache-line traffic between cores:
+//   ping-pong     one line bounced between every pair of CPUs; one-way
+//                 latency (round trip / 2), printed as a matrix
+//   contended     1..N threads doing fetch_add on one shared counter
+//   false sharing per-thread counters `padding` bytes apart
+// CPUs are labelled with their socket and L3 domain (CCX/CCD on AMD, the
+// whole die on most Intel parts) so the boundaries show in the matrix.
+struct CpuTopo
+{
+    int cpu;
+    int socket = -1;
+    int l3 = -1;                    // L3 domain: lowest CPU sharing the L3
+    int core = -1;
+};
+
+static vector<CpuTopo> cpu_topology(const vector<int>& cpus)
+{
+    vector<CpuTopo> v;
+    for (int c : cpus)
+    {
+        CpuTopo t;
+        t.cpu = c;
+#if defined(__linux__)
+        string base = "/sys/devices/system/cpu/cpu" + to_string(c);
+        string pkg = read_text(base + "/topology/physical_package_id");
+        string core = read_text(base + "/topology/core_id");
+        if (!pkg.empty()) t.socket = atoi(pkg.c_str());
+        if (!core.empty()) t.core = atoi(core.c_str());
+        for (int idx = 0; idx < 8; ++idx)
+        {
+            string cache = base + "/cache/index" + to_string(idx);
+            if (read_text(cache + "/level") != "3") continue;
+            vector<int> shared = parse_list(read_text(cache + "/shared_cpu_list"));
+            if (!shared.empty()) t.l3 = shared[0];
+        }
+#endif
+        v.push_back(t);
+    }
+    return v;
+}
+
+static string topo_label(const CpuTopo& t)
+{
+    return "s" + (t.socket < 0 ? string("?") : to_string(t.socket)) + "/L3@" +
+           (t.l3 < 0 ? string("?") : to_string(t.l3));
+}
+
+// Bounces one line between CPUs a and b: a writes an odd value, b answers
+// with the next even one. The spin loops do not pause, so the numbers are
+// the coherence round trip and not the pause latency. Returns ns one-way.
+static Stats pingpong_ns(int a, int b, int iters)
+{
+    const uint64_t kStop = ~0ULL, rounds = 2000;
+    PaddedCounter line;
+    RepLoop loop(iters);
+
+    thread pong([&]
+    {
+        pin_thread(b);
+        uint64_t last = 0;
+        for (;;)
+        {
+            uint64_t v;
+            while ((v = line.v.load(memory_order_acquire)) == last) {}
+            if (v == kStop) break;
+            last = v + 1;
+            line.v.store(last, memory_order_release);
+        }
+    });
+    thread ping([&]
+    {
+        pin_thread(a);
+        uint64_t v = 0;
+        auto batch = [&]
+        {
+            for (uint64_t i = 0; i < rounds; ++i)
+            {
+                line.v.store(++v, memory_order_release);
+                ++v;
+                while (line.v.load(memory_order_acquire) != v) {}
+            }
+        };
+        batch();                                    // warmup
+        bool done = false;
+        while (!done)
+        {
+            uint64_t t0 = tnow();
+            batch();
+            uint64_t t1 = tnow();
+            done = loop.add(tsec(t0, t1));
+        }
+        line.v.store(kStop, memory_order_release);
+    });
+    ping.join();
+    pong.join();
+    return loop.stats([&](double sec) { return sec * 1e9 / (2.0 * rounds); });
+}
+
+// Runs body(t) on `threads` CPUs released together from a barrier; each
+// sample is the slowest thread's time. Returns Mops/s for `opsPerThread`
+// operations per thread.
+template <typename F>
+static Stats parallel_mops(const vector<int>& cpus, int threads, uint64_t opsPerThread,
+                           int iters, F body)
+{
+    RepLoop loop(iters);
+    bool done = false;
+    bool warm = false;
+    while (!done)
+    {
+        vector<double> secs(threads);
+        SpinBarrier bar(threads);
+        vector<thread> pool;
+        for (int t = 0; t < threads; ++t)
+        {
+            pool.emplace_back([&, t]
+            {
+                pin_thread(cpus[t % cpus.size()]);
+                bar.wait();
+                uint64_t t0 = tnow();
+                body(t, opsPerThread);
+                uint64_t t1 = tnow();
+                secs[t] = tsec(t0, t1);
+            });
+        }
+        for (auto& th : pool) th.join();
+        if (warm) done = loop.add(*max_element(secs.begin(), secs.end()));
+        warm = true;
+    }
+    double ops = (double)opsPerThread * threads;
+    return loop.stats([&](double sec) { return ops / sec / 1e6; });
+}
+
+static void runC2C(const vector<int>& cpus, const vector<int>& paddings, int iters)
+{
+    vector<CpuTopo> topo = cpu_topology(cpus);
+    int n = (int)cpus.size();
+
+    cout << "Core-to-core (" << n << " CPUs)\n";
+    for (const CpuTopo& t : topo)
+        cout << "  cpu " << setw(4) << t.cpu << "  " << topo_label(t) << "  core "
+             << t.core << "\n";
+
+    if (n < 2)
+    {
+        cout << "Ping-pong and false sharing need at least 2 CPUs\n";
+    }
+    else
+    {
+        // Per-class averages: same core (SMT), same L3, same socket, cross-socket.
+        double sum[4] = {}, cnt[4] = {};
+        const char* const kClass[4] = { "smt", "same_l3", "same_socket", "cross_socket" };
+        cout << "Ping-pong one-way latency (ns), row = writer CPU, column = responder\n";
+        cout << setw(6) << "";
+        for (int j = 0; j < n; ++j) cout << setw(7) << topo[j].cpu;
+        cout << "\n";
+        for (int i = 0; i < n; ++i)
+        {
+            cout << setw(6) << topo[i].cpu;
+            for (int j = 0; j < n; ++j)
+            {
+                if (i == j)
+                {
+                    cout << setw(7) << "-";
+                    continue;
+                }
+                Stats s = pingpong_ns(topo[i].cpu, topo[j].cpu, iters);
+                cout << setw(7) << fixed << setprecision(1) << s.value << flush;
+                record("c2c.cpu" + to_string(topo[i].cpu) + ".cpu" + to_string(topo[j].cpu) +
+                       ".ns", s, "ns", false);
+                const CpuTopo &x = topo[i], &y = topo[j];
+                int cls = x.socket != y.socket            ? 3
+                        : x.l3 < 0 || x.l3 != y.l3        ? 2
+                        : x.core >= 0 && x.core == y.core ? 0 : 1;
+                sum[cls] += s.value;
+                cnt[cls] += 1;
+            }
+            // Mark the L3-domain boundaries so CCX/CCD edges stand out.
+            bool edge = i + 1 < n && (topo[i + 1].l3 != topo[i].l3 ||
+                                      topo[i + 1].socket != topo[i].socket);
+            cout << "  " << topo_label(topo[i]) << (edge ? "\n      ----" : "") << "\n";
+        }
+        for (int k = 0; k < 4; ++k)
+        {
+            if (!cnt[k]) continue;
+            cout << "  avg " << left << setw(13) << kClass[k] << right << fixed
+                 << setprecision(1) << sum[k] / cnt[k] << " ns\n";
+            record(string("c2c.avg.") + kClass[k] + ".ns", sum[k] / cnt[k], "ns", false);
+        }
+    }
+
+    const uint64_t kOps = 200000;
+    cout << "Contended fetch_add on one line (ns/op is per thread)\n";
+    cout << setw(8) << "threads" << setw(12) << "Mops/s" << setw(12) << "ns/op" << "\n";
+    PaddedCounter shared;
+    for (int t = 1; t <= n; t = (t * 2 > n && t < n) ? n : t * 2)
+    {
+        Stats s = parallel_mops(cpus, t, kOps, iters, [&](int, uint64_t ops)
+        {
+            for (uint64_t i = 0; i < ops; ++i) shared.v.fetch_add(1, memory_order_relaxed);
+        });
+        cout << setw(8) << t << fixed << setprecision(2) << setw(12) << s.value
+             << setw(12) << 1e3 * t / s.value << endl;
+        record("c2c.atomic.t" + to_string(t) + ".mops", s, "Mops/s", true);
+    }
+    sink64 ^= shared.v.load();
+
+    if (n < 2) return;
+    cout << "False sharing: " << n << " threads, one plain counter each, `padding` bytes apart\n";
+    cout << setw(8) << "padding" << setw(12) << "Mops/s" << setw(12) << "ns/op" << "\n";
+    for (int pad : paddings)
+    {
+        size_t p = max<size_t>(sizeof(uint64_t), (size_t)pad & ~(sizeof(uint64_t) - 1));
+        char* buf = (char*)alloc_aligned(p * n + kLine, 4096);
+        memset(buf, 0, p * n + kLine);
+        Stats s = parallel_mops(cpus, n, kOps * 10, iters, [&](int t, uint64_t ops)
+        {
+            volatile uint64_t* c = reinterpret_cast<volatile uint64_t*>(buf + t * p);
+            for (uint64_t i = 0; i < ops; ++i) *c = *c + 1;
+        });
+        free_aligned(buf);
+        cout << setw(8) << p << fixed << setprecision(2) << setw(12) << s.value
+             << setw(12) << 1e3 * n / s.value << endl;
+        record("c2c.false_sharing.pad" + to_string(p) + ".mops", s, "Mops/s", true);
+    }
+}
+
+//====================================================
+// Atomic read-modify-write kernels (--atomics)
+//====================================================
+// Per tier, one operation per cache line of the buffer (lines are spread
+// over the whole tier, capped at kRmwMaxOps per pass):
+//   store         plain 8-byte store (baseline)
+//   store_relaxed atomic store, memory_order_relaxed
+//   store_seq_cst atomic store, memory_order_seq_cst (xchg / stlr)
+//   exchange      atomic exchange
+//   fetch_add     atomic fetch_add
+//   cas           load + compare_exchange of value + 1
+// Uncontended runs on one thread; contended runs N pinned threads that walk
+// the same line sequence together, so every line is fought over.
+// Dependent latency chains the ring built by build_chains through the RMW
+// itself (fetch_add of 0, a failing CAS), which loads alone cannot show.
+enum RmwOp { RmwStore, RmwRelaxed, RmwSeqCst, RmwExchange, RmwFetchAdd, RmwCas, kNumRmw };
+static const char* const kRmwNames[kNumRmw] = {
+    "store", "store_relaxed", "store_seq_cst", "exchange", "fetch_add", "cas" };
+static const size_t kRmwMaxOps = 1 << 18;
+
+template <int Op>
+static double rmw_pass(char* buf, size_t lines, size_t step, size_t first, uint64_t ops)
+{
+    uint64_t acc = 0;
+    size_t l = first % lines;
+    for (uint64_t i = 0; i < ops; ++i)
+    {
+        uint64_t* q = reinterpret_cast<uint64_t*>(buf + l * kLine);
+        if (Op == RmwStore) *reinterpret_cast<volatile uint64_t*>(q) = i;
+        else if (Op == RmwRelaxed) __atomic_store_n(q, i, __ATOMIC_RELAXED);
+        else if (Op == RmwSeqCst) __atomic_store_n(q, i, __ATOMIC_SEQ_CST);
+        else if (Op == RmwExchange) acc += __atomic_exchange_n(q, i, __ATOMIC_SEQ_CST);
+        else if (Op == RmwFetchAdd) acc += __atomic_fetch_add(q, 1, __ATOMIC_SEQ_CST);
+        else
+        {
+            uint64_t e = __atomic_load_n(q, __ATOMIC_RELAXED);
+            acc += __atomic_compare_exchange_n(q, &e, e + 1, false, __ATOMIC_SEQ_CST,
+                                               __ATOMIC_RELAXED);
+        }
+        l += step;
+        if (l >= lines) l -= lines;
+    }
+    return (double)acc;
+}
+
+using RmwFn = double (*)(char*, size_t, size_t, size_t, uint64_t);
+static const RmwFn kRmwPass[kNumRmw] = {
+    rmw_pass<RmwStore>, rmw_pass<RmwRelaxed>, rmw_pass<RmwSeqCst>,
+    rmw_pass<RmwExchange>, rmw_pass<RmwFetchAdd>, rmw_pass<RmwCas> };
+
+// Dependent RMW chase over a build_chains ring; ns per op.
+template <int Op>
+static Stats rmw_chase_ns(char* head, int iters)
+{
+    uintptr_t* p = reinterpret_cast<uintptr_t*>(head);
+    auto step = [&](uint64_t n)
+    {
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            if (Op == RmwFetchAdd)
+            {
+                p = reinterpret_cast<uintptr_t*>(__atomic_fetch_add(p, 0, __ATOMIC_SEQ_CST));
+            }
+            else
+            {
+                uintptr_t e = 0;            // never matches a link, so e receives it
+                __atomic_compare_exchange_n(p, &e, 0, false, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+                p = reinterpret_cast<uintptr_t*>(e);
+            }
+        }
+    };
+    step(2000);
+    uint64_t n = 4096;
+    auto batch = [&]
+    {
+        uint64_t t0 = tnow();
+        step(n);
+        uint64_t t1 = tnow();
+        return tsec(t0, t1);
+    };
+    while (batch() < 200e-6 && n < (1ULL << 26)) n *= 2;
+    RepLoop loop(iters);
+    while (!loop.add(batch())) {}
+    sink64 ^= (uint64_t)(uintptr_t)p;
+    return loop.stats([&](double sec) { return sec * 1e9 / (double)n; });
+}
+
+static void runAtomics(char* buf, const vector<pair<const char*, size_t>>& tiers, int threads,
+                       int iters)
+{
+    const vector<int>& cpus = online_cpus();
+    bool contended = threads >= 2;
+    cout << "Atomic RMW (Mops/s and ns/op; x store = cost relative to a plain store; "
+         << "contended = " << threads << " threads on the same lines)\n";
+    cout << left << setw(8) << "Tier" << setw(15) << "op" << right << setw(10) << "Mops/s"
+         << setw(9) << "ns/op" << setw(9) << "x store" << setw(12) << "cont_Mops"
+         << setw(12) << "cont_ns/thr" << setw(9) << "dep_ns" << "\n";
+    for (const auto& t : tiers)
+    {
+        size_t lines = max<size_t>(1, t.second * 1024ULL / kLine);
+        uint64_t ops = min<uint64_t>(lines, kRmwMaxOps);
+        size_t step = max<size_t>(1, lines / ops);
+        memset(buf, 0, lines * kLine);
+
+        double storeNs = 0;
+        Stats dep[kNumRmw];
+        {
+            char* head = build_chains(buf, lines * kLine, kLine)[0];
+            dep[RmwFetchAdd] = rmw_chase_ns<RmwFetchAdd>(head, iters);
+            dep[RmwCas] = rmw_chase_ns<RmwCas>(head, iters);
+        }
+        for (int op = 0; op < kNumRmw; ++op)
+        {
+            RmwFn fn = kRmwPass[op];
+            Stats s = run_reps([&] { return fn(buf, lines, step, 0, ops); }, iters)
+                          .stats([&](double sec) { return ops / sec / 1e6; });
+            double ns = 1e3 / s.value;
+            if (op == RmwStore) storeNs = ns;
+            string key = string("atomic.") + t.first + "." + kRmwNames[op];
+            cout << left << setw(8) << t.first << setw(15) << kRmwNames[op] << right << fixed
+                 << setprecision(2) << setw(10) << s.value << setw(9) << ns << setw(9)
+                 << ns / storeNs;
+            record(key + ".mops", s, "Mops/s", true);
+
+            if (contended)
+            {
+                uint64_t per = max<uint64_t>(1, ops / threads);
+                vector<uint64_t> sinks(threads);
+                Stats c = parallel_mops(cpus, threads, per, iters, [&](int th, uint64_t n)
+                {
+                    sinks[th] ^= (uint64_t)fn(buf, lines, step, 0, n);
+                });
+                for (uint64_t v : sinks) sink64 ^= v;
+                cout << setw(12) << c.value << setw(12) << 1e3 * threads / c.value;
+                record(key + ".contended_mops", c, "Mops/s", true);
+            }
+            else
+            {
+                cout << setw(12) << "-" << setw(12) << "-";
+            }
+
+            if (dep[op].n)
+            {
+                cout << setw(9) << dep[op].value;
+                record(key + ".dep_ns", dep[op], "ns", false);
+            }
+            else
+            {
+                cout << setw(9) << "-";
+            }
+            cout << endl;
+        }
+    }
+    if (!contended) cout << "Contended columns need --threads >= 2 (or more than one CPU)\n";
+}
+
+//====================================================
+// File I/O tier (--io FILE)
+//====================================================
+// Reads one file (created with --ioMB MB of data if missing, removed again
+// afterwards) in several modes and prints them in Row style next to
+// anonymous DRAM:
+//   mmap-cold      page cache evicted, fresh mapping (major faults)
+//   mmap-warm      page cache hot, fresh mapping (minor faults only)
+//   mmap-seq       as warm, with MADV_SEQUENTIAL (larger fault-around)
+//   mmap-willneed  page cache evicted, MADV_WILLNEED readahead then read
+//   pread-cold     pread into alloc_aligned buffers, page cache evicted
+//   pread-warm     pread into alloc_aligned buffers, page cache hot
+//   direct         O_DIRECT (F_NOCACHE on macOS), 4 KB-aligned buffers
+// Seq reads the whole file in 1 MB chunks, Rand reads 4 KB blocks in random
+// order, Latency is the time of one random 8-byte load (mmap) or one random
+// 4 KB pread. The cold modes evict with POSIX_FADV_DONTNEED before every
+// repetition; a residency check reports when the kernel kept pages anyway.
+struct IoRow
+{
+    string mode;
+    Stats seq, rnd, lat;
+    bool ok = false;
+};
+
+static const size_t kIoBlock = 4096, kIoChunk = 1 << 20;
+
+static bool io_evict(int fd)
+{
+#if defined(__linux__)
+    fdatasync(fd);
+    return posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+#else
+    (void)fd;
+    return false;
+#endif
+}
+
+// Fraction of the file's pages that are in the page cache.
+static double io_resident(int fd, size_t bytes)
+{
+    void* m = mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (m == MAP_FAILED) return -1;
+    size_t pages = (bytes + kIoBlock - 1) / kIoBlock;
+#if defined(__APPLE__)
+    vector<char> vec(pages);
+#else
+    vector<unsigned char> vec(pages);
+#endif
+    size_t in = 0;
+    if (mincore(m, bytes, vec.data()) == 0)
+        for (auto v : vec) in += v & 1;
+    munmap(m, bytes);
+    return (double)in / pages;
+}
+
+static void io_warm(int fd, size_t bytes, char* tmp)
+{
+    for (size_t off = 0; off < bytes; off += kIoChunk)
+        if (pread(fd, tmp, min(kIoChunk, bytes - off), (off_t)off) < 0) break;
+}
+
+// One mmap pass over a fresh mapping; the advice and the accesses are timed,
+// mmap/munmap are not. kind: 0 = seq, 1 = random 4 KB blocks, 2 = random
+// single loads (latency samples).
+static double io_mmap_pass(int fd, size_t bytes, int advice, int kind,
+                           const vector<size_t>& blocks, size_t samples)
+{
+    char* p = (char*)mmap(nullptr, bytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) return -1;
+    uint64_t t0 = tnow();
+    if (advice) madvise(p, bytes, advice);
+    double v = 0;
+    if (kind == 0)
+    {
+        v = g_kernel->read(nullptr, p, bytes & ~(size_t)(kLine - 1));
+    }
+    else if (kind == 1)
+    {
+        for (size_t b : blocks) v += g_kernel->read(nullptr, p + b * kIoBlock, kIoBlock);
+    }
+    else
+    {
+        for (size_t i = 0; i < samples; ++i)
+            v += (double)*reinterpret_cast<const volatile uint64_t*>(p + blocks[i] * kIoBlock);
+    }
+    uint64_t t1 = tnow();
+    munmap(p, bytes);
+    sink64 ^= (uint64_t)v;
+    return tsec(t0, t1);
+}
+
+// One timed pread pass into `tmp` (kIoChunk bytes, suitably aligned).
+static double io_pread_pass(int fd, size_t bytes, int kind, const vector<size_t>& blocks,
+                            size_t samples, char* tmp)
+{
+    uint64_t t0 = tnow();
+    bool ok = true;
+    if (kind == 0)
+    {
+        for (size_t off = 0; off + kIoBlock <= bytes && ok; off += kIoChunk)
+        {
+            size_t n = min(kIoChunk, (bytes - off) & ~(kIoBlock - 1));
+            ok = pread(fd, tmp, n, (off_t)off) == (ssize_t)n;
+        }
+    }
+    else
+    {
+        size_t n = kind == 1 ? blocks.size() : samples;
+        for (size_t i = 0; i < n && ok; ++i)
+            ok = pread(fd, tmp, kIoBlock, (off_t)(blocks[i] * kIoBlock)) == (ssize_t)kIoBlock;
+    }
+    uint64_t t1 = tnow();
+    sink64 ^= (uint64_t)tmp[0];
+    return ok ? tsec(t0, t1) : -1;
+}
+
+// capMB limits how much of an existing file is read (0 = all of it);
+// createMB is the size written when the file does not exist yet. Existing
+// paths are only ever read, and only regular files are accepted (a block
+// device stats as size 0 and must never be written or unlinked).
+static void runIo(const string& path, size_t capMB, size_t createMB, int iters)
+{
+    bool created = false;
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        if (!S_ISREG(st.st_mode) || st.st_size == 0)
+        {
+            cerr << "--io " << path << ": "
+                 << (S_ISREG(st.st_mode) ? "file is empty" : "not a regular file") << "\n";
+            return;
+        }
+    }
+    else if (errno != ENOENT)
+    {
+        cerr << "Cannot stat " << path << ": " << strerror(errno) << "\n";
+        return;
+    }
+    else
+    {
+        int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_EXCL, 0644);
+        if (fd < 0)
+        {
+            cerr << "Cannot create " << path << ": " << strerror(errno) << "\n";
+            return;
+        }
+        vector<char> chunk(kIoChunk);
+        mt19937_64 rng(1234567);
+        for (auto& c : chunk) c = (char)rng();
+        for (size_t i = 0; i < createMB; ++i)
+        {
+            if (write(fd, chunk.data(), kIoChunk) != (ssize_t)kIoChunk)
+            {
+                cerr << "Cannot write " << path << ": " << strerror(errno) << "\n";
+                close(fd);
+                unlink(path.c_str());
+                return;
+            }
+        }
+        fsync(fd);
+        close(fd);
+        created = true;
+        stat(path.c_str(), &st);
+    }
+
+    size_t bytes = (size_t)st.st_size & ~(kIoBlock - 1);
+    if (capMB && !created) bytes = min(bytes, capMB << 20);
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0 || bytes < kIoBlock)
+    {
+        cerr << "Cannot read " << path << (fd < 0 ? string(": ") + strerror(errno) : string()) << "\n";
+        if (fd >= 0) close(fd);
+        return;
+    }
+
+    size_t nBlocks = bytes / kIoBlock;
+    vector<size_t> blocks(nBlocks);
+    for (size_t i = 0; i < nBlocks; ++i) blocks[i] = i;
+    mt19937_64 rng(1234567);
+    shuffle(blocks.begin(), blocks.end(), rng);
+    blocks.resize(min<size_t>(nBlocks, 16384));     // Rand reads up to 64 MB
+    size_t samples = min<size_t>(blocks.size(), 1024);
+    char* tmp = (char*)alloc_aligned(kIoChunk, kIoBlock);
+
+    bool evictOk = true;
+    // Runs pass() through a RepLoop, prep() untimed before every sample.
+    auto measure = [&](auto prep, auto pass, auto toValue)
+    {
+        RepLoop loop(iters);
+        bool done = false, ok = true;
+        while (!done && ok)
+        {
+            prep();
+            double sec = pass();
+            ok = sec > 0;
+            if (ok) done = loop.add(sec);
+        }
+        return loop.stats(toValue);
+    };
+    auto cold = [&]
+    {
+        evictOk = io_evict(fd) && evictOk;
+        if (io_resident(fd, bytes) > 0.1) evictOk = false;
+    };
+    auto warm = [&] { io_warm(fd, bytes, tmp); };
+
+    auto seqGB = [&](double sec) { return bytes / sec / 1e9; };
+    auto rndGB = [&](double sec) { return blocks.size() * kIoBlock / sec / 1e9; };
+    auto latNs = [&](double sec) { return sec * 1e9 / (double)samples; };
+    vector<IoRow> rows;
+    auto mmapRow = [&](const char* name, bool isCold, int advice)
+    {
+        IoRow r;
+        r.mode = name;
+        auto prep = [&] { if (isCold) cold(); else warm(); };
+        r.seq = measure(prep, [&] { return io_mmap_pass(fd, bytes, advice, 0, blocks, 0); }, seqGB);
+        r.rnd = measure(prep, [&] { return io_mmap_pass(fd, bytes, advice, 1, blocks, 0); }, rndGB);
+        r.lat = measure(prep, [&] { return io_mmap_pass(fd, bytes, advice, 2, blocks, samples); }, latNs);
+        r.ok = r.seq.n > 0;
+        rows.push_back(r);
+    };
+    auto preadRow = [&](const char* name, int rfd, bool isCold)
+    {
+        IoRow r;
+        r.mode = name;
+        auto prep = [&] { if (isCold) cold(); };
+        if (!isCold && rfd == fd) warm();
+        r.seq = measure(prep, [&] { return io_pread_pass(rfd, bytes, 0, blocks, 0, tmp); }, seqGB);
+        r.rnd = measure(prep, [&] { return io_pread_pass(rfd, bytes, 1, blocks, 0, tmp); }, rndGB);
+        r.lat = measure(prep, [&] { return io_pread_pass(rfd, bytes, 2, blocks, samples, tmp); }, latNs);
+        r.ok = r.seq.n > 0;
+        rows.push_back(r);
+    };
+
+    mmapRow("mmap-cold", true, 0);
+    mmapRow("mmap-warm", false, 0);
+    mmapRow("mmap-seq", false, MADV_SEQUENTIAL);
+    mmapRow("mmap-willneed", true, MADV_WILLNEED);
+    preadRow("pread-cold", fd, true);
+    preadRow("pread-warm", fd, false);
+
+#if defined(O_DIRECT)
+    int dfd = open(path.c_str(), O_RDONLY | O_DIRECT);
+#else
+    int dfd = open(path.c_str(), O_RDONLY);
+#if defined(F_NOCACHE)
+    if (dfd >= 0) fcntl(dfd, F_NOCACHE, 1);
+#endif
+#endif
+    if (dfd >= 0)
+    {
+        preadRow("direct", dfd, false);
+        close(dfd);
+    }
+    else
+    {
+        IoRow r;
+        r.mode = "direct";
+        rows.push_back(r);
+    }
+
+    // The anonymous-memory reference row, same units.
+    size_t dramBytes = blocks.size() * kIoBlock;
+    char* anon = (char*)alloc_aligned(dramBytes, 4096);
+    memset(anon, 1, dramBytes);
+    IoRow dram;
+    dram.mode = "dram";
+    dram.seq = bw_read_gbs(anon, dramBytes, iters);
+    dram.lat = latency_ns(anon, dramBytes, kLine, iters);
+    dram.ok = true;
+    free_aligned(anon);
+
+    cout << "File I/O (" << path << ", " << (bytes >> 20) << " MB; Rand = "
+         << ((blocks.size() * kIoBlock) >> 20) << " MB of random 4 KB blocks)\n";
+    for (const IoRow& r : rows)
+    {
+        cout << left << setw(14) << r.mode;
+        if (!r.ok)
+        {
+            cout << "  unavailable on this file system\n";
+            continue;
+        }
+        cout << "  Seq ";  fmt(r.seq);
+        cout << "  Rand4K "; fmt(r.rnd);
+        cout << "  Latency " << right << setw(10) << fixed << setprecision(0) << r.lat.value
+             << " ns" << (r.lat.unstable ? '*' : ' ') << "\n";
+        string key = "io." + r.mode;
+        record(key + ".seq_gbs", r.seq, "GB/s", true);
+        record(key + ".rand4k_gbs", r.rnd, "GB/s", true);
+        record(key + ".latency_ns", r.lat, "ns", false);
+    }
+    cout << left << setw(14) << dram.mode << "  Seq "; fmt(dram.seq);
+    cout << "  Rand4K " << setw(14) << "" << "  Latency " << right << setw(10) << fixed
+         << setprecision(0) << dram.lat.value << " ns" << (dram.lat.unstable ? '*' : ' ') << "\n";
+    record("io.dram.seq_gbs", dram.seq, "GB/s", true);
+    record("io.dram.latency_ns", dram.lat, "ns", false);
+    if (!evictOk)
+        cout << "note: page cache eviction (POSIX_FADV_DONTNEED) was incomplete; "
+                "cold rows may be partly warm\n";
+
+    free_aligned(tmp);
+    close(fd);
+    if (created) unlink(path.c_str());
+}
+
+//====================================================
+// Page-fault and first-touch cost (--faults)
+//====================================================
+// For 4 KB, THP and hugetlb 2 MB / 1 GB buffers of --faultMB MB, times:
+//   lazy-1T     first write to every 4 KB of a fresh mapping, one thread
+//   lazy-NT     the same split over N pinned threads (aggregate wall time)
+//   populate    mmap with MAP_POPULATE / MADV_POPULATE_WRITE, no touch
+//   dontneed    madvise(MADV_DONTNEED) of the touched buffer
+//   refault     first touch again after MADV_DONTNEED
+// Results are microseconds per page of that kind and milliseconds per GB,
+// so arenas can be sized either way. main's untimed warm touch is what
+// lazy-1T measures.
+static size_t page_bytes(PageKind k)
+{
+    return k == PageKind::Huge1G ? (1ULL << 30)
+         : (k == PageKind::THP || k == PageKind::Huge2M) ? (1ULL << 21) : 4096;
+}
+
+static void touch_pages(char* p, size_t bytes)
+{
+    for (size_t off = 0; off < bytes; off += 4096) p[off] = 1;
+}
+
+// Wall time for `threads` threads pinned round-robin to `cpus` to touch
+// their slices of [p, +bytes), from a barrier release to the last finishing.
+static double touch_parallel(char* p, size_t bytes, int threads,
+                             const vector<int>& cpus = online_cpus())
+{
+    size_t slice = round_up(bytes / threads, 4096);
+    SpinBarrier bar(threads + 1);
+    vector<thread> pool;
+    for (int t = 0; t < threads; ++t)
+    {
+        pool.emplace_back([&, t]
+        {
+            pin_thread(cpus[t % cpus.size()]);
+            size_t lo = min(bytes, t * slice), hi = min(bytes, lo + slice);
+            bar.wait();
+            touch_pages(p + lo, hi - lo);
+        });
+    }
+    bar.wait();
+    uint64_t t0 = tnow();
+    for (auto& th : pool) th.join();
+    uint64_t t1 = tnow();
+    return tsec(t0, t1);
+}
+
+static void runFaults(size_t MB, int threads, int iters)
+{
+    size_t bytes = MB << 20;
+    cout << "Page faults / first touch (" << MB << " MB; us per page, ms per GB)\n";
+    cout << left << setw(7) << "pages" << setw(16) << "mode" << right << setw(12) << "us/page"
+         << setw(12) << "ms/GB" << "\n";
+
+    for (PageKind kind : { PageKind::Small, PageKind::THP, PageKind::Huge2M, PageKind::Huge1G })
+    {
+        const char* kn = page_kind_name(kind);
+        size_t pb = page_bytes(kind);
+        size_t len = round_up(bytes, pb);
+        double perPage = (double)len / pb, perGB = len / 1e9;
+
+        auto report = [&](const string& mode, const Stats& s)
+        {
+            cout << left << setw(7) << kn << setw(16) << mode << right << fixed
+                 << setprecision(2) << setw(12) << s.value * 1e6 / perPage
+                 << setw(12) << s.value * 1e3 / perGB << (s.unstable ? "*" : "") << endl;
+            string key = string("faults.") + kn + "." + mode;
+            record(key + ".us_per_page", s.value * 1e6 / perPage, "us", false);
+            record(key + ".ms_per_gb", s.value * 1e3 / perGB, "ms", false);
+        };
+
+        Buffer probe = alloc_buffer(bytes, kind);
+        if (!probe.p)
+        {
+            cout << left << setw(7) << kn << "unavailable (no pages reserved or not supported)\n";
+            continue;
+        }
+        free_buffer(probe);
+
+        // Each sample maps a fresh buffer; fn(buffer) returns the timed seconds.
+        auto sample = [&](bool populate, auto fn)
+        {
+            RepLoop loop(iters);
+            bool done = false;
+            while (!done)
+            {
+                uint64_t t0 = tnow();
+                Buffer b = alloc_buffer(bytes, kind, populate);
+                uint64_t t1 = tnow();
+                if (!b.p) break;
+                done = loop.add(fn(b, tsec(t0, t1)));
+                free_buffer(b);
+            }
+            return loop.stats([](double sec) { return sec; });
+        };
+
+        auto lazy1 = [&](Buffer& b, double)
+        {
+            uint64_t t0 = tnow();
+            touch_pages(b.p, b.bytes);
+            uint64_t t1 = tnow();
+            return tsec(t0, t1);
+        };
+        report("lazy-1T", sample(false, lazy1));
+        if (threads > 1)
+            report("lazy-" + to_string(threads) + "T",
+                   sample(false, [&](Buffer& b, double) { return touch_parallel(b.p, b.bytes, threads); }));
+
+        Stats pop = sample(true, [](Buffer&, double mapSec) { return mapSec; });
+        if (pop.n) report("populate", pop);
+        else cout << left << setw(7) << kn << setw(16) << "populate" << "unsupported\n";
+
+#if defined(__linux__)
+        Buffer b = alloc_buffer(bytes, kind);
+        RepLoop dn(iters), re(iters);
+        bool done = false;
+        while (!done)
+        {
+            touch_pages(b.p, b.bytes);
+            uint64_t t0 = tnow();
+            madvise(b.p, b.bytes, MADV_DONTNEED);
+            uint64_t t1 = tnow();
+            touch_pages(b.p, b.bytes);
+            uint64_t t2 = tnow();
+            bool d1 = dn.add(tsec(t0, t1));
+            done = re.add(tsec(t1, t2)) && d1;
+        }
+        free_buffer(b);
+        report("dontneed", dn.stats([](double sec) { return sec; }));
+        report("refault", re.stats([](double sec) { return sec; }));
+#endif
+    }
+}
+
+//====================================================
+// Allocator workloads (--alloc)
+//====================================================
+// Runs three allocation patterns against each allocator:
+//   churn    one thread keeps a window of 1024 small objects (16..256 B) and
+//            replaces a random one per op
+//   p/c      a producer thread allocates, a consumer thread frees (remote free)
+//   frag     a large live set of 16 B..4 KB objects with random replacement
+//            (long-running fragmentation); RSS growth is reported after it
+// and then chases a pointer ring through the live objects in slot order,
+// which shows how well the allocator keeps neighbouring allocations close.
+// "malloc" is whatever the process links, so jemalloc/tcmalloc are measured
+// by running under LD_PRELOAD (DYLD_INSERT_LIBRARIES on macOS); the preload
+// is named in the output.
+struct Allocator
+{
+    virtual ~Allocator() {}
+    virtual const char* name() const = 0;
+    virtual void begin(size_t maxSize) { (void)maxSize; }   // new workload
+    virtual void* alloc(size_t n) = 0;
+    virtual void release(void* p, bool remote) = 0;         // remote: other thread
+    virtual void end() {}                                   // all objects released
+};
+
+struct MallocAllocator : Allocator
+{
+    const char* name() const override { return "malloc"; }
+    void* alloc(size_t n) override { return malloc(n); }
+    void release(void* p, bool) override { free(p); }
+};
+
+struct MemalignAllocator : Allocator
+{
+    const char* name() const override { return "posix_memalign"; }
+    void* alloc(size_t n) override { return alloc_aligned(n, kLine); }
+    void release(void* p, bool) override { free_aligned(p); }
+};
+
+// Bump allocator over 4 MB chunks; free is a no-op, end() drops everything.
+struct BumpArena : Allocator
+{
+    static constexpr size_t kChunk = 4 << 20;
+    vector<char*> chunks;
+    char* cur = nullptr;
+    size_t left = 0;
+
+    const char* name() const override { return "bump-arena"; }
+    void* alloc(size_t n) override
+    {
+        n = round_up(n, 16);
+        if (n > left)
+        {
+            cur = (char*)alloc_aligned(max(n, kChunk), 4096);
+            chunks.push_back(cur);
+            left = max(n, kChunk);
+        }
+        void* p = cur;
+        cur += n;
+        left -= n;
+        return p;
+    }
+    void release(void*, bool) override {}
+    void end() override
+    {
+        for (char* c : chunks) free_aligned(c);
+        chunks.clear();
+        cur = nullptr;
+        left = 0;
+    }
+    ~BumpArena() override { end(); }
+};
+
+// Fixed-size slots carved from 1 MB chunks. The owning thread uses a plain
+// free list; other threads push onto an atomic remote list that the owner
+// takes over wholesale when its own list runs dry (no ABA: only the owner pops).
+struct FixedPool : Allocator
+{
+    struct Slot { Slot* next; };
+    static constexpr size_t kChunk = 1 << 20;
+    size_t slot = 64;
+    vector<char*> chunks;
+    Slot* local = nullptr;
+    atomic<Slot*> remote{nullptr};
+
+    const char* name() const override { return "fixed-pool"; }
+    void begin(size_t maxSize) override { slot = round_up(max(maxSize, sizeof(Slot)), 16); }
+    void* alloc(size_t) override
+    {
+        if (!local) local = remote.exchange(nullptr, memory_order_acquire);
+        if (!local)
+        {
+            size_t bytes = max(kChunk, slot);
+            char* c = (char*)alloc_aligned(bytes, 4096);
+            chunks.push_back(c);
+            for (size_t off = bytes / slot * slot; off >= slot; off -= slot)
+            {
+                Slot* s = reinterpret_cast<Slot*>(c + off - slot);
+                s->next = local;
+                local = s;
+            }
+        }
+        Slot* s = local;
+        local = s->next;
+        return s;
+    }
+    void release(void* p, bool isRemote) override
+    {
+        Slot* s = static_cast<Slot*>(p);
+        if (!isRemote)
+        {
+            s->next = local;
+            local = s;
+            return;
+        }
+        Slot* head = remote.load(memory_order_relaxed);
+        do s->next = head;
+        while (!remote.compare_exchange_weak(head, s, memory_order_release, memory_order_relaxed));
+    }
+    void end() override
+    {
+        for (char* c : chunks) free_aligned(c);
+        chunks.clear();
+        local = nullptr;
+        remote.store(nullptr);
+    }
+    ~FixedPool() override { end(); }
+};
+
+// Resident set size in bytes (Linux; 0 elsewhere).
+static size_t rss_bytes()
+{
+#if defined(__linux__)
+    size_t total = 0, resident = 0;
+    FILE* f = fopen("/proc/self/statm", "r");
+    if (!f) return 0;
+    if (fscanf(f, "%zu %zu", &total, &resident) != 2) resident = 0;
+    fclose(f);
+    return resident * (size_t)getpagesize();
+#else
+    return 0;
+#endif
+}
+
+static string preload_name()
+{
+#if defined(__APPLE__)
+    const char* v = getenv("DYLD_INSERT_LIBRARIES");
+#else
+    const char* v = getenv("LD_PRELOAD");
+#endif
+    return v && *v ? string(v) : string();
+}
+
+// Links the live objects into a ring in slot order and chases it.
+static Stats chase_objects(vector<void*>& live, int iters)
+{
+    for (size_t i = 0; i < live.size(); ++i)
+        *static_cast<void**>(live[i]) = live[(i + 1) % live.size()];
+    return chase_latency(static_cast<char*>(live[0]), iters);
+}
+
+struct AllocResult
+{
+    Stats churn, pc, frag, churnChase, fragChase;
+    double rssMB = 0;
+};
+
+static AllocResult bench_allocator(Allocator& A, uint64_t ops, int iters)
+{
+    AllocResult r;
+    mt19937_64 rng(1234567);
+    const uint64_t batch = max<uint64_t>(1000, ops);
+
+    // Replaces a random live object `n` times; returns the timed seconds.
+    auto replace = [&](vector<void*>& live, uint64_t n, size_t minSz, size_t maxSz)
+    {
+        uint64_t t0 = tnow();
+        for (uint64_t i = 0; i < n; ++i)
+        {
+            size_t k = rng() % live.size();
+            A.release(live[k], false);
+            live[k] = A.alloc(minSz + rng() % (maxSz - minSz + 1));
+            *static_cast<char*>(live[k]) = 1;
+        }
+        uint64_t t1 = tnow();
+        return tsec(t0, t1);
+    };
+    auto mops = [&](double sec) { return batch / sec / 1e6; };
+    auto drop = [&](vector<void*>& live)
+    {
+        for (void* p : live) A.release(p, false);
+        live.clear();
+        A.end();
+    };
+
+    // churn
+    {
+        A.begin(256);
+        vector<void*> live(1024);
+        for (auto& p : live) p = A.alloc(16 + rng() % 241);
+        RepLoop loop(iters);
+        while (!loop.add(replace(live, batch, 16, 256))) {}
+        r.churn = loop.stats(mops);
+        r.churnChase = chase_objects(live, iters);
+        drop(live);
+    }
+
+    // producer / consumer through a single-producer single-consumer ring
+    {
+        A.begin(256);
+        const vector<int>& cpus = online_cpus();
+        RepLoop loop(iters);
+        bool done = false;
+        while (!done)
+        {
+            const size_t kRing = 1024;
+            vector<void*> ring(kRing);
+            PaddedCounter head, tail;
+            SpinBarrier bar(3);
+            thread prod([&]
+            {
+                pin_thread(cpus[0]);
+                mt19937_64 prng(42);
+                bar.wait();
+                for (uint64_t i = 0; i < batch; ++i)
+                {
+                    void* p = A.alloc(16 + prng() % 241);
+                    *static_cast<char*>(p) = 1;
+                    uint64_t h = head.v.load(memory_order_relaxed);
+                    while (h - tail.v.load(memory_order_acquire) >= kRing) this_thread::yield();
+                    ring[h % kRing] = p;
+                    head.v.store(h + 1, memory_order_release);
+                }
+            });
+            thread cons([&]
+            {
+                pin_thread(cpus[1 % cpus.size()]);
+                bar.wait();
+                for (uint64_t i = 0; i < batch; ++i)
+                {
+                    uint64_t t = tail.v.load(memory_order_relaxed);
+                    while (head.v.load(memory_order_acquire) == t) this_thread::yield();
+                    A.release(ring[t % kRing], true);
+                    tail.v.store(t + 1, memory_order_release);
+                }
+            });
+            bar.wait();
+            uint64_t t0 = tnow();
+            prod.join();
+            cons.join();
+            uint64_t t1 = tnow();
+            done = loop.add(tsec(t0, t1));
+        }
+        r.pc = loop.stats(mops);
+        A.end();
+    }
+
+    // fragmentation
+    {
+        A.begin(4096);
+        size_t before = rss_bytes();
+        vector<void*> live(max<uint64_t>(1024, ops / 4));
+        for (auto& p : live) p = A.alloc(16 + rng() % 4081);
+        RepLoop loop(iters);
+        while (!loop.add(replace(live, batch, 16, 4096))) {}
+        r.frag = loop.stats(mops);
+        size_t after = rss_bytes();
+        r.rssMB = after > before ? (after - before) / 1048576.0 : 0;
+        r.fragChase = chase_objects(live, iters);
+        drop(live);
+    }
+    return r;
+}
+
+static void runAlloc(uint64_t ops, int iters)
+{
+    MallocAllocator m;
+    MemalignAllocator pm;
+    BumpArena arena;
+    FixedPool pool;
+    Allocator* all[] = { &m, &pm, &arena, &pool };
+
+    string pre = preload_name();
+    cout << "Allocator workloads (Mops/s = alloc+free pairs; " << ops << " ops per sample";
+    if (!pre.empty()) cout << "; malloc = " << pre;
+    cout << ")\n";
+    cout << left << setw(16) << "allocator" << right << setw(10) << "churn" << setw(10) << "p/c"
+         << setw(10) << "frag" << setw(12) << "fragRSS_MB" << setw(13) << "churnChase"
+         << setw(12) << "fragChase" << "\n";
+    for (Allocator* a : all)
+    {
+        AllocResult r = bench_allocator(*a, ops, iters);
+        cout << left << setw(16) << a->name() << right << fixed << setprecision(2)
+             << setw(10) << r.churn.value << setw(10) << r.pc.value << setw(10) << r.frag.value
+             << setw(12) << setprecision(1) << r.rssMB << setw(10) << setprecision(2)
+             << r.churnChase.value << " ns" << setw(9) << r.fragChase.value << " ns" << endl;
+        string key = string("alloc.") + a->name();
+        record(key + ".churn_mops", r.churn, "Mops/s", true);
+        record(key + ".pc_mops", r.pc, "Mops/s", true);
+        record(key + ".frag_mops", r.frag, "Mops/s", true);
+        record(key + ".frag_rss_mb", r.rssMB, "MB", false);
+        record(key + ".churn_chase_ns", r.churnChase, "ns", false);
+        record(key + ".frag_chase_ns", r.fragChase, "ns", false);
+    }
+}
+
+//====================================================
+// Data-layout traversal (--layout)
+//====================================================
+// The same N records of F fields x B bytes laid out three ways:
+//   aos    record after record
+//   soa    one array per field
+//   aosoa  blocks of L records, each block stored field by field
+// Kernels walk records in the order application code does (record-major,
+// every 4-byte word of each visited field):
+//   full   every field of every record
+//   field  field 0 of every record
+//   rand   every field of randomly chosen records
+// Results are useful bytes/s (only the fields asked for) and ns per record.
+enum Layout { LayAoS, LaySoA, LayAoSoA, kNumLayouts };
+static const char* const kLayoutNames[kNumLayouts] = { "aos", "soa", "aosoa" };
+
+struct LayoutSpec
+{
+    size_t n;                       // records
+    size_t fields;
+    size_t words;                   // 4-byte words per field
+    size_t block;                   // AoSoA records per block (power of two)
+    unsigned shift;                 // log2(block)
+};
+
+template <int L>
+static inline const uint32_t* field_ptr(const char* base, const LayoutSpec& s, size_t r, size_t f)
+{
+    size_t w;
+    if (L == LayAoS) w = r * s.fields + f;
+    else if (L == LaySoA) w = f * s.n + r;
+    else w = ((r >> s.shift) * s.fields + f) * s.block + (r & (s.block - 1));
+    return reinterpret_cast<const uint32_t*>(base) + w * s.words;
+}
+
+template <int L, size_t W>
+static double lay_full(const char* b, const LayoutSpec& s, const vector<uint32_t>&)
+{
+    uint64_t sum = 0;
+    for (size_t r = 0; r < s.n; ++r)
+        for (size_t f = 0; f < s.fields; ++f)
+        {
+            const uint32_t* p = field_ptr<L>(b, s, r, f);
+            for (size_t w = 0; w < (W ? W : s.words); ++w) sum += p[w];
+        }
+    return (double)sum;
+}
+
+template <int L, size_t W>
+static double lay_field(const char* b, const LayoutSpec& s, const vector<uint32_t>&)
+{
+    uint64_t sum = 0;
+    for (size_t r = 0; r < s.n; ++r)
+    {
+        const uint32_t* p = field_ptr<L>(b, s, r, 0);
+        for (size_t w = 0; w < (W ? W : s.words); ++w) sum += p[w];
+    }
+    return (double)sum;
+}
+
+template <int L, size_t W>
+static double lay_rand(const char* b, const LayoutSpec& s, const vector<uint32_t>& idx)
+{
+    uint64_t sum = 0;
+    for (uint32_t r : idx)
+        for (size_t f = 0; f < s.fields; ++f)
+        {
+            const uint32_t* p = field_ptr<L>(b, s, r, f);
+            for (size_t w = 0; w < (W ? W : s.words); ++w) sum += p[w];
+        }
+    return (double)sum;
+}
+
+using LayoutFn = double (*)(const char*, const LayoutSpec&, const vector<uint32_t>&);
+
+// Kernels for one field width; W = 0 reads s.words at run time.
+template <size_t W>
+struct LayoutKernels
+{
+    static constexpr LayoutFn fn[3][kNumLayouts] = {
+        { lay_full<LayAoS, W>,  lay_full<LaySoA, W>,  lay_full<LayAoSoA, W> },
+        { lay_field<LayAoS, W>, lay_field<LaySoA, W>, lay_field<LayAoSoA, W> },
+        { lay_rand<LayAoS, W>,  lay_rand<LaySoA, W>,  lay_rand<LayAoSoA, W> },
+    };
+};
+
+// Field widths of 4/8/16/32 B get fixed-width inner loops.
+static LayoutFn layout_kernel(int kind, int layout, size_t words)
+{
+    switch (words)
+    {
+        case 1:  return LayoutKernels<1>::fn[kind][layout];
+        case 2:  return LayoutKernels<2>::fn[kind][layout];
+        case 4:  return LayoutKernels<4>::fn[kind][layout];
+        case 8:  return LayoutKernels<8>::fn[kind][layout];
+        default: return LayoutKernels<0>::fn[kind][layout];
+    }
+}
+
+static void runLayout(char* buf, const vector<pair<const char*, size_t>>& tiers, size_t fields,
+                      size_t fieldBytes, size_t block, int iters)
+{
+    LayoutSpec s{ 0, fields, fieldBytes / 4, block, 0 };
+    while ((1ULL << s.shift) < block) ++s.shift;
+    const size_t recBytes = fields * fieldBytes;
+
+    cout << "Data layout (" << fields << " fields x " << fieldBytes << " B, AoSoA block "
+         << block << "; useful GB/s and ns/record)\n";
+    cout << left << setw(8) << "Tier" << setw(7) << "layout" << right << setw(10) << "full_GBs"
+         << setw(9) << "full_ns" << setw(11) << "field_GBs" << setw(10) << "field_ns"
+         << setw(10) << "rand_GBs" << setw(9) << "rand_ns" << "\n";
+    for (const auto& t : tiers)
+    {
+        s.n = max<size_t>(block, (t.second * 1024ULL / recBytes) & ~(block - 1));
+        vector<uint32_t> idx(min<size_t>(s.n, 1 << 16));
+        mt19937_64 rng(1234567);
+        for (auto& i : idx) i = (uint32_t)(rng() % s.n);
+
+        const double records[3] = { (double)s.n, (double)s.n, (double)idx.size() };
+        const double useful[3] = { (double)recBytes, (double)fieldBytes, (double)recBytes };
+        const char* const kKind[3] = { "full", "field", "rand" };
+        for (int L = 0; L < kNumLayouts; ++L)
+        {
+            cout << left << setw(8) << t.first << setw(7) << kLayoutNames[L] << right << fixed
+                 << setprecision(2);
+            for (int k = 0; k < 3; ++k)
+            {
+                LayoutFn fn = layout_kernel(k, L, s.words);
+                Stats st = run_reps([&] { return fn(buf, s, idx); }, iters)
+                               .stats([&](double sec) { return sec * 1e9 / records[k]; });
+                double gbs = useful[k] / st.value;
+                cout << setw(k ? 11 : 10) << gbs << setw(k == 1 ? 10 : 9) << st.value;
+                string key = string("layout.") + t.first + "." + kLayoutNames[L] + "." + kKind[k];
+                record(key + "_gbs", gbs, "GB/s", true, st.n > 1 ? 100.0 * st.stddev / st.median : 0);
+                record(key + "_ns_per_record", st, "ns", false);
+            }
+            cout << endl;
+        }
+    }
+}
+
+//====================================================
+// Linked structures (--structs)
+//====================================================
+// Index-shaped workloads built inside the tier buffer, sized to each tier:
+//   open-addr   linear-probing table of 16 B {key, value} slots, load 0.7
+//   chained     bucket array + 32 B nodes from a pool in insertion order
+//   btree-N     static B+tree with N-byte nodes of N/16 {max key, child}
+//               pairs, branchless binary search inside each node
+//   list-pool   32 B list nodes carved contiguously from the buffer, in order
+//   list-malloc the same nodes from malloc, linked in shuffled order
+// Tables and trees are probed with a batch of random present keys
+// (independent lookups, so the core may overlap them); lists are walked as
+// a dependent chase. Results are M lookups/s and ns per lookup (per node
+// for lists).
+static inline uint64_t hash64(uint64_t k)
+{
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccdULL;
+    k ^= k >> 33;
+    return k;
+}
+
+static vector<uint64_t> random_keys(size_t n, uint64_t seed)
+{
+    vector<uint64_t> keys(n);
+    mt19937_64 rng(seed);
+    for (auto& k : keys) k = rng() | 1;             // never 0 (the empty marker)
+    return keys;
+}
+
+struct OpenTable
+{
+    uint64_t* slots;                // key, value pairs
+    size_t mask;                    // capacity - 1
+};
+
+// Largest power-of-two table of 16 B slots that fits in `bytes`.
+static size_t open_capacity(size_t bytes)
+{
+    size_t cap = 1;
+    while (cap * 2 * 16 <= bytes) cap *= 2;
+    return cap;
+}
+
+static OpenTable build_open(char* buf, size_t cap, const vector<uint64_t>& keys)
+{
+    OpenTable t{ reinterpret_cast<uint64_t*>(buf), cap - 1 };
+    memset(buf, 0, cap * 16);
+    for (uint64_t k : keys)
+    {
+        size_t i = hash64(k) & t.mask;
+        while (t.slots[2 * i] && t.slots[2 * i] != k) i = (i + 1) & t.mask;
+        t.slots[2 * i] = k;
+        t.slots[2 * i + 1] = k ^ 0x5555;
+    }
+    return t;
+}
+
+static double probe_open(const OpenTable& t, const vector<uint64_t>& q)
+{
+    uint64_t sum = 0;
+    for (uint64_t k : q)
+    {
+        size_t i = hash64(k) & t.mask;
+        while (t.slots[2 * i] != k && t.slots[2 * i]) i = (i + 1) & t.mask;
+        sum += t.slots[2 * i + 1];
+    }
+    return (double)sum;
+}
+
+struct ChainNode
+{
+    uint64_t key, value;
+    ChainNode* next;
+    uint64_t pad;
+};
+
+struct ChainTable
+{
+    ChainNode** buckets;
+    size_t mask;
+};
+
+static ChainTable build_chained(char* buf, size_t buckets, const vector<uint64_t>& keys)
+{
+    ChainTable t{ reinterpret_cast<ChainNode**>(buf), buckets - 1 };
+    memset(buf, 0, buckets * sizeof(ChainNode*));
+    ChainNode* pool = reinterpret_cast<ChainNode*>(buf + buckets * sizeof(ChainNode*));
+    for (size_t i = 0; i < keys.size(); ++i)
+    {
+        ChainNode* n = &pool[i];
+        ChainNode*& head = t.buckets[hash64(keys[i]) & t.mask];
+        *n = { keys[i], keys[i] ^ 0x5555, head, 0 };
+        head = n;
+    }
+    return t;
+}
+
+static double probe_chained(const ChainTable& t, const vector<uint64_t>& q)
+{
+    uint64_t sum = 0;
+    for (uint64_t k : q)
+    {
+        const ChainNode* n = t.buckets[hash64(k) & t.mask];
+        while (n && n->key != k) n = n->next;
+        sum += n ? n->value : 0;
+    }
+    return (double)sum;
+}
+
+// Node layout: K keys then K child pointers; unused keys are UINT64_MAX.
+// Internal key i is the largest key below child i; leaves hold the keys.
+struct BTree
+{
+    const char* root;
+    size_t fanout;                  // K
+    int depth;                      // levels including the leaves
+    size_t bytes;                   // bytes used by all nodes
+};
+
+static BTree build_btree(char* buf, size_t nodeBytes, const vector<uint64_t>& sorted)
+{
+    const size_t K = nodeBytes / 16;
+    auto keyAt = [&](char* n) { return reinterpret_cast<uint64_t*>(n); };
+    auto childAt = [&](char* n) { return reinterpret_cast<char**>(n + K * 8); };
+
+    char* next = buf;
+    vector<pair<uint64_t, char*>> level;            // (max key, node) of the level below
+    for (size_t i = 0; i < sorted.size(); i += K)
+    {
+        char* n = next;
+        next += nodeBytes;
+        for (size_t j = 0; j < K; ++j)
+        {
+            keyAt(n)[j] = i + j < sorted.size() ? sorted[i + j] : ~0ULL;
+            childAt(n)[j] = nullptr;
+        }
+        level.push_back({ sorted[min(i + K, sorted.size()) - 1], n });
+    }
+    int depth = 1;
+    while (level.size() > 1)
+    {
+        vector<pair<uint64_t, char*>> up;
+        for (size_t i = 0; i < level.size(); i += K)
+        {
+            char* n = next;
+            next += nodeBytes;
+            for (size_t j = 0; j < K; ++j)
+            {
+                bool used = i + j < level.size();
+                keyAt(n)[j] = used ? level[i + j].first : ~0ULL;
+                childAt(n)[j] = used ? level[i + j].second : nullptr;
+            }
+            up.push_back({ level[min(i + K, level.size()) - 1].first, n });
+        }
+        level.swap(up);
+        ++depth;
+    }
+    return { level[0].second, K, depth, (size_t)(next - buf) };
+}
+
+static double probe_btree(const BTree& t, const vector<uint64_t>& q)
+{
+    uint64_t hits = 0;
+    const size_t K = t.fanout;
+    for (uint64_t k : q)
+    {
+        const char* n = t.root;
+        for (int d = 0; d < t.depth; ++d)
+        {
+            const uint64_t* keys = reinterpret_cast<const uint64_t*>(n);
+            const uint64_t* base = keys;
+            for (size_t len = K; len > 1; len -= len / 2)
+                base += (size_t)(base[len / 2 - 1] < k) * (len / 2);
+            size_t i = (size_t)(base - keys) + (*base < k);
+            if (d + 1 == t.depth)
+            {
+                hits += i < K && keys[i] == k;
+                break;
+            }
+            n = reinterpret_cast<char* const*>(n + K * 8)[min(i, K - 1)];
+        }
+    }
+    return (double)hits;
+}
+
+static void runStructs(char* buf, const vector<pair<const char*, size_t>>& tiers, int iters)
+{
+    const size_t kQueries = 1 << 16;
+    cout << "Linked structures (M lookups/s and ns/lookup; lists: per node)\n";
+    cout << left << setw(8) << "Tier" << setw(13) << "structure" << right << setw(11) << "size_KB"
+         << setw(12) << "Mlookups/s" << setw(11) << "ns/lookup" << "\n";
+
+    for (const auto& t : tiers)
+    {
+        size_t bytes = t.second * 1024ULL;
+        auto report = [&](const char* name, size_t usedBytes, const Stats& ns)
+        {
+            cout << left << setw(8) << t.first << setw(13) << name << right << setw(11)
+                 << (usedBytes >> 10) << fixed << setprecision(2) << setw(12) << 1e3 / ns.value
+                 << setw(11) << ns.value << (ns.unstable ? "*" : "") << endl;
+            record(string("structs.") + t.first + "." + name + ".ns", ns, "ns", false);
+        };
+        auto probe = [&](auto fn, const vector<uint64_t>& q)
+        {
+            return run_reps(fn, iters).stats([&](double sec) { return sec * 1e9 / q.size(); });
+        };
+        auto queries = [&](const vector<uint64_t>& keys)
+        {
+            vector<uint64_t> q(kQueries);
+            mt19937_64 rng(7654321);
+            for (auto& k : q) k = keys[rng() % keys.size()];
+            return q;
+        };
+
+        {
+            size_t cap = open_capacity(bytes);
+            vector<uint64_t> keys = random_keys(max<size_t>(1, cap * 7 / 10), 1);
+            OpenTable ot = build_open(buf, cap, keys);
+            vector<uint64_t> q = queries(keys);
+            report("open-addr", (ot.mask + 1) * 16, probe([&] { return probe_open(ot, q); }, q));
+        }
+        {
+            size_t buckets = 1;
+            while (buckets * 2 * (sizeof(ChainNode*) + sizeof(ChainNode)) <= bytes) buckets *= 2;
+            vector<uint64_t> keys = random_keys(buckets, 2);
+            ChainTable ct = build_chained(buf, buckets, keys);
+            vector<uint64_t> q = queries(keys);
+            report("chained", buckets * (sizeof(ChainNode*) + sizeof(ChainNode)),
+                   probe([&] { return probe_chained(ct, q); }, q));
+        }
+        for (size_t nb : { 64, 256, 4096 })
+        {
+            size_t K = nb / 16;
+            size_t n = max<size_t>(K, bytes / nb * (K - 1));
+            vector<uint64_t> keys = random_keys(n, 3);
+            sort(keys.begin(), keys.end());
+            keys.erase(unique(keys.begin(), keys.end()), keys.end());
+            BTree bt = build_btree(buf, nb, keys);
+            vector<uint64_t> q = queries(keys);
+            string name = "btree-" + to_string(nb);
+            report(name.c_str(), bt.bytes, probe([&] { return probe_btree(bt, q); }, q));
+        }
+        {
+            const size_t kNode = 32;
+            size_t n = max<size_t>(2, bytes / kNode);
+            vector<size_t> offs(n);
+            for (size_t i = 0; i < n; ++i) offs[i] = i * kNode;
+            report("list-pool", n * kNode, chase_latency(link_ring(buf, offs), iters));
+
+            vector<char*> nodes(n);
+            for (auto& p : nodes) p = (char*)malloc(kNode);
+            mt19937_64 rng(1234567);
+            shuffle(nodes.begin(), nodes.end(), rng);
+            for (size_t i = 0; i < n; ++i) *reinterpret_cast<char**>(nodes[i]) = nodes[(i + 1) % n];
+            report("list-malloc", n * kNode, chase_latency(nodes[0], iters));
+            for (char* p : nodes) free(p);
+        }
+    }
+}
+
+//====================================================
+// memcpy / memset shoot-out (--copy)
+//====================================================
+// Compares libc memcpy/memmove/memset with rep movsb/stosb (x86), plain
+// AVX2/AVX-512/NEON loops and the selected kernel's non-temporal copy/fill
+// (a) over a power-of-two size sweep and (b) over src/dst misalignments at
+// one size. Small sizes are called back to back on hot buffers, the way
+// copies inside hot loops behave. Results are GB/s and ns per call.
+static inline void small_copy(char* d, const char* s, size_t n)
+{
+    // Two possibly overlapping moves cover any n in [k, 2k].
+    if (n >= 16)
+    {
+        uint64_t a, b, c, e;
+        memcpy(&a, s, 8); memcpy(&b, s + 8, 8);
+        memcpy(&c, s + n - 16, 8); memcpy(&e, s + n - 8, 8);
+        memcpy(d, &a, 8); memcpy(d + 8, &b, 8);
+        memcpy(d + n - 16, &c, 8); memcpy(d + n - 8, &e, 8);
+    }
+    else if (n >= 8)
+    {
+        uint64_t a, b;
+        memcpy(&a, s, 8); memcpy(&b, s + n - 8, 8);
+        memcpy(d, &a, 8); memcpy(d + n - 8, &b, 8);
+    }
+    else if (n >= 4)
+    {
+        uint32_t a, b;
+        memcpy(&a, s, 4); memcpy(&b, s + n - 4, 4);
+        memcpy(d, &a, 4); memcpy(d + n - 4, &b, 4);
+    }
+    else
+    {
+        for (size_t i = 0; i < n; ++i) d[i] = s[i];
+    }
+}
+
+static double copy_memcpy(char* d, const char* s, size_t n) { memcpy(d, s, n); return 0; }
+static double copy_memmove(char* d, const char* s, size_t n) { memmove(d, s, n); return 0; }
+static double set_memset(char* d, const char*, size_t n) { memset(d, 1, n); return 0; }
+
+#if defined(CB_X86) && defined(__x86_64__)
+static double copy_movsb(char* d, const char* s, size_t n)
+{
+    asm volatile("rep movsb" : "+D"(d), "+S"(s), "+c"(n) : : "memory");
+    return 0;
+}
+
+static double set_stosb(char* d, const char*, size_t n)
+{
+    asm volatile("rep stosb" : "+D"(d), "+c"(n) : "a"(1) : "memory");
+    return 0;
+}
+#endif
+
+#if defined(CB_X86)
+// Unaligned vector loops; the last vector overlaps the one before it.
+__attribute__((target("avx2")))
+static double copy_avx2(char* d, const char* s, size_t n)
+{
+    if (n < 32)
+    {
+        small_copy(d, s, n);
+        return 0;
+    }
+    size_t i = 0;
+    for (; i + 128 <= n; i += 128)
+    {
+        __m256i v0 = _mm256_loadu_si256((const __m256i*)(s + i));
+        __m256i v1 = _mm256_loadu_si256((const __m256i*)(s + i + 32));
+        __m256i v2 = _mm256_loadu_si256((const __m256i*)(s + i + 64));
+        __m256i v3 = _mm256_loadu_si256((const __m256i*)(s + i + 96));
+        _mm256_storeu_si256((__m256i*)(d + i), v0);
+        _mm256_storeu_si256((__m256i*)(d + i + 32), v1);
+        _mm256_storeu_si256((__m256i*)(d + i + 64), v2);
+        _mm256_storeu_si256((__m256i*)(d + i + 96), v3);
+    }
+    for (; i + 32 <= n; i += 32)
+        _mm256_storeu_si256((__m256i*)(d + i), _mm256_loadu_si256((const __m256i*)(s + i)));
+    if (i < n)
+        _mm256_storeu_si256((__m256i*)(d + n - 32), _mm256_loadu_si256((const __m256i*)(s + n - 32)));
+    return 0;
+}
+
+__attribute__((target("avx2")))
+static double set_avx2(char* d, const char*, size_t n)
+{
+    if (n < 32)
+    {
+        memset(d, 1, n);
+        return 0;
+    }
+    const __m256i v = _mm256_set1_epi8(1);
+    size_t i = 0;
+    for (; i + 32 <= n; i += 32) _mm256_storeu_si256((__m256i*)(d + i), v);
+    if (i < n) _mm256_storeu_si256((__m256i*)(d + n - 32), v);
+    return 0;
+}
+
+__attribute__((target("avx512f")))
+static double copy_avx512(char* d, const char* s, size_t n)
+{
+    if (n < 64)
+    {
+        small_copy(d, s, n);
+        return 0;
+    }
+    size_t i = 0;
+    for (; i + 256 <= n; i += 256)
+    {
+        __m512i v0 = _mm512_loadu_si512(s + i), v1 = _mm512_loadu_si512(s + i + 64);
+        __m512i v2 = _mm512_loadu_si512(s + i + 128), v3 = _mm512_loadu_si512(s + i + 192);
+        _mm512_storeu_si512(d + i, v0);
+        _mm512_storeu_si512(d + i + 64, v1);
+        _mm512_storeu_si512(d + i + 128, v2);
+        _mm512_storeu_si512(d + i + 192, v3);
+    }
+    for (; i + 64 <= n; i += 64) _mm512_storeu_si512(d + i, _mm512_loadu_si512(s + i));
+    if (i < n) _mm512_storeu_si512(d + n - 64, _mm512_loadu_si512(s + n - 64));
+    return 0;
+}
+
+__attribute__((target("avx512f")))
+static double set_avx512(char* d, const char*, size_t n)
+{
+    if (n < 64)
+    {
+        memset(d, 1, n);
+        return 0;
+    }
+    const __m512i v = _mm512_set1_epi32(0x01010101);
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64) _mm512_storeu_si512(d + i, v);
+    if (i < n) _mm512_storeu_si512(d + n - 64, v);
+    return 0;
+}
+#endif
+
+#if defined(__ARM_NEON)
+static double copy_neon(char* d, const char* s, size_t n)
+{
+    if (n < 16)
+    {
+        small_copy(d, s, n);
+        return 0;
+    }
+    size_t i = 0;
+    for (; i + 64 <= n; i += 64)
+    {
+        uint8x16_t v0 = vld1q_u8((const uint8_t*)s + i), v1 = vld1q_u8((const uint8_t*)s + i + 16);
+        uint8x16_t v2 = vld1q_u8((const uint8_t*)s + i + 32), v3 = vld1q_u8((const uint8_t*)s + i + 48);
+        vst1q_u8((uint8_t*)d + i, v0);
+        vst1q_u8((uint8_t*)d + i + 16, v1);
+        vst1q_u8((uint8_t*)d + i + 32, v2);
+        vst1q_u8((uint8_t*)d + i + 48, v3);
+    }
+    for (; i + 16 <= n; i += 16) vst1q_u8((uint8_t*)d + i, vld1q_u8((const uint8_t*)s + i));
+    if (i < n) vst1q_u8((uint8_t*)d + n - 16, vld1q_u8((const uint8_t*)s + n - 16));
+    return 0;
+}
+
+static double set_neon(char* d, const char*, size_t n)
+{
+    if (n < 16)
+    {
+        memset(d, 1, n);
+        return 0;
+    }
+    const uint8x16_t v = vdupq_n_u8(1);
+    size_t i = 0;
+    for (; i + 16 <= n; i += 16) vst1q_u8((uint8_t*)d + i, v);
+    if (i < n) vst1q_u8((uint8_t*)d + n - 16, v);
+    return 0;
+}
+#endif
+
+static double copy_nt_selected(char* d, const char* s, size_t n) { return g_kernel->copy_nt(d, s, n); }
+static double set_nt_selected(char* d, const char* s, size_t n) { return g_kernel->write_nt(d, s, n); }
+
+struct CopyImpl
+{
+    const char* name;
+    bool (*available)();
+    PassFn fn;
+};
+
+static const CopyImpl kCopyImpls[] =
+{
+    { "memcpy",  has_scalar, copy_memcpy },
+    { "memmove", has_scalar, copy_memmove },
+#if defined(CB_X86) && defined(__x86_64__)
+    { "movsb",   has_scalar, copy_movsb },
+#endif
+#if defined(CB_X86)
+    { "avx2",    has_avx2,   copy_avx2 },
+    { "avx512",  has_avx512, copy_avx512 },
+#endif
+#if defined(__ARM_NEON)
+    { "neon",    has_neon,   copy_neon },
+#endif
+    { "nt",      has_scalar, copy_nt_selected },
+};
+
+static const CopyImpl kSetImpls[] =
+{
+    { "memset",  has_scalar, set_memset },
+#if defined(CB_X86) && defined(__x86_64__)
+    { "stosb",   has_scalar, set_stosb },
+#endif
+#if defined(CB_X86)
+    { "avx2",    has_avx2,   set_avx2 },
+    { "avx512",  has_avx512, set_avx512 },
+#endif
+#if defined(__ARM_NEON)
+    { "neon",    has_neon,   set_neon },
+#endif
+    { "nt",      has_scalar, set_nt_selected },
+};
+
+// ns per call of fn(dst, src, n); small sizes are batched so one sample
+// moves at least 256 KB.
+static Stats copy_call_ns(PassFn fn, char* dst, const char* src, size_t n, int iters)
+{
+    const size_t calls = max<size_t>(1, (256u << 10) / max<size_t>(n, 1));
+    return run_reps([&]
+    {
+        double v = 0;
+        for (size_t c = 0; c < calls; ++c) v += fn(dst, src, n);
+        return v;
+    }, iters).stats([&](double sec) { return sec * 1e9 / (double)calls; });
+}
+
+static void runCopy(char* dst, char* src, size_t maxBytes, size_t alignSize,
+                    const vector<int>& misalign, int iters)
+{
+    struct Family { const char* kind; const CopyImpl* impls; size_t count; };
+    const Family fams[] = {
+        { "copy", kCopyImpls, sizeof(kCopyImpls) / sizeof(kCopyImpls[0]) },
+        { "set",  kSetImpls,  sizeof(kSetImpls) / sizeof(kSetImpls[0]) },
+    };
+
+    for (const Family& f : fams)
+    {
+        vector<const CopyImpl*> impls;
+        for (size_t i = 0; i < f.count; ++i)
+            if (f.impls[i].available()) impls.push_back(&f.impls[i]);
+
+        auto header = [&](const char* first)
+        {
+            cout << right << setw(12) << first;
+            for (const CopyImpl* c : impls) cout << setw(10) << c->name;
+            cout << "\n";
+        };
+
+        // a) size sweep, 64 B-aligned buffers: GB/s and ns/call side by side
+        cout << "Size sweep: " << f.kind << " GB/s | ns/call (nt = " << g_kernel->name << ")\n";
+        header("bytes");
+        for (size_t n = 1; n <= maxBytes; n *= 2)
+        {
+            vector<Stats> r;
+            for (const CopyImpl* c : impls) r.push_back(copy_call_ns(c->fn, dst, src, n, iters));
+            cout << setw(12) << n << fixed << setprecision(2);
+            for (const Stats& s : r) cout << setw(10) << n / s.value;
+            cout << "\n" << setw(12) << "";
+            for (const Stats& s : r) cout << setw(10) << setprecision(s.value < 1e4 ? 1 : 0) << s.value;
+            cout << endl;
+            for (size_t i = 0; i < impls.size(); ++i)
+            {
+                string key = string(f.kind) + "." + impls[i]->name + "." + to_string(n) + "B";
+                record(key + ".ns_per_call", r[i], "ns", false);
+                record(key + ".gbs", n / r[i].value, "GB/s", true);
+            }
+        }
+
+        // b) misalignment sweep at one size: GB/s and ns/call with dst (and
+        //    for copies src) offset by m bytes from a 64 B boundary
+        const char* const kWhich[2] = { "dst", "src" };
+        for (int w = 0; w < (f.impls == kCopyImpls ? 2 : 1); ++w)
+        {
+            cout << "Misalignment: " << f.kind << " " << alignSize << " B, " << kWhich[w]
+                 << " + m, GB/s | ns/call\n";
+            header("m");
+            for (int m : misalign)
+            {
+                if (m < 0 || m > 63) continue;
+                char* d = dst + (w == 0 ? m : 0);
+                const char* s = src + (w == 1 ? m : 0);
+                vector<Stats> r;
+                for (const CopyImpl* c : impls) r.push_back(copy_call_ns(c->fn, d, s, alignSize, iters));
+                cout << setw(12) << m << fixed << setprecision(2);
+                for (const Stats& st : r) cout << setw(10) << alignSize / st.value;
+                cout << "\n" << setw(12) << "";
+                for (const Stats& st : r) cout << setw(10) << setprecision(st.value < 1e4 ? 1 : 0) << st.value;
+                cout << endl;
+                for (size_t i = 0; i < impls.size(); ++i)
+                {
+                    string key = string(f.kind) + "." + impls[i]->name + ".align_" + kWhich[w] +
+                                 to_string(m);
+                    record(key + ".ns_per_call", r[i], "ns", false);
+                    record(key + ".gbs", alignSize / r[i].value, "GB/s", true);
+                }
+            }
+        }
+    }
+}
+
+//====================================================
+// TLB reach (--tlb)
+//====================================================
+// Chases one line per page over a growing number of pages, in random page
+// order so the next-page prefetcher cannot help. The line inside each page is
+// random too: a fixed or index-derived offset would map the lines of a
+// physically contiguous huge page onto a handful of cache sets. Latency steps up where the page count
+// outgrows the L1 DTLB, then the STLB, then the page-walk caches; the same
+// 4 KB-step walk on huge pages shows the cache-only cost underneath.
+static const size_t kTlbMinPages = 8;
+
+static vector<size_t> tlb_page_counts(size_t maxPages)
+{
+    vector<size_t> v;
+    for (size_t n = kTlbMinPages; n <= maxPages; n *= 2)
+    {
+        v.push_back(n);
+        if (n + n / 2 <= maxPages) v.push_back(n + n / 2);
+    }
+    return v;
+}
+
+static Stats tlb_chase_ns(char* buf, size_t pages, size_t step, int iters)
+{
+    vector<size_t> order(pages);
+    for (size_t i = 0; i < pages; ++i) order[i] = i;
+    mt19937_64 rng(1234567);
+    shuffle(order.begin(), order.end(), rng);
+
+    size_t lines = step / kLine;
+    vector<size_t> offs(pages);
+    for (size_t i = 0; i < pages; ++i) offs[i] = order[i] * step + (rng() % lines) * kLine;
+    return chase_latency(link_ring(buf, offs), iters);
+}
+
+// Marks a point whose latency is more than 20% above the previous one.
+static const char* tlb_knee(double prev, double cur)
+{
+    return (prev > 0 && cur > prev * 1.2) ? " <" : "  ";
+}
+
+// Free pages in the hugetlb pool of `k` (SIZE_MAX for THP / 4 KB pages or
+// when the pool size cannot be read).
+static size_t free_hugetlb_pages(PageKind k)
+{
+    if (k != PageKind::Huge2M && k != PageKind::Huge1G) return SIZE_MAX;
+    string v = read_text("/sys/kernel/mm/hugepages/hugepages-" + to_string(page_bytes(k) >> 10) +
+                         "kB/free_hugepages");
+    return v.empty() ? SIZE_MAX : (size_t)strtoull(v.c_str(), nullptr, 10);
+}
+
+// The 4 KB-step walk on huge pages and the huge-step walk get separate
+// buffers: one maxHugePages x 1 GB allocation would never fit, and its
+// failure used to drop both tables to THP.
+static void runTlb(size_t maxPages, size_t maxHugePages, PageKind hugeKind, int iters)
+{
+    size_t smallBytes = maxPages * 4096;
+    Buffer small = alloc_buffer(smallBytes, PageKind::Small);
+    Buffer huge = alloc_buffer(smallBytes, hugeKind);
+    if (!huge.p && hugeKind != PageKind::THP)
+    {
+        cerr << "warning: " << page_kind_name(hugeKind) << " pages unavailable, using thp\n";
+        hugeKind = PageKind::THP;
+        huge = alloc_buffer(smallBytes, hugeKind);
+    }
+    if (!small.p || !huge.p)
+    {
+        cerr << "--tlb: buffer allocation failed\n";
+        free_buffer(small);
+        free_buffer(huge);
+        return;
+    }
+    touch_pages(small.p, small.bytes);
+    touch_pages(huge.p, huge.bytes);
+    const string hk = page_kind_name(hugeKind);
+
+    cout << "TLB reach, one line per 4 KB page: 4k [" << describe_pages(small) << "] vs "
+         << hk << " [" << describe_pages(huge) << "]  ('<' = >20% step)\n";
+    cout << right << setw(10) << "pages" << setw(10) << "span_MB" << setw(12) << "4k_ns"
+         << "  " << setw(12) << hk + "_ns" << "  " << setw(10) << "tlb_ns" << "\n";
+    double prevS = 0, prevH = 0;
+    for (size_t n : tlb_page_counts(maxPages))
+    {
+        double s = tlb_chase_ns(small.p, n, 4096, iters).value;
+        double h = tlb_chase_ns(huge.p, n, 4096, iters).value;
+        cout << right << setw(10) << n << fixed << setprecision(2) << setw(10) << n * 4096 / 1048576.0
+             << setw(12) << s << tlb_knee(prevS, s) << setw(12) << h << tlb_knee(prevH, h)
+             << setw(10) << s - h << endl;
+        record("tlb.4k_step." + to_string(n) + "pages.4k.latency_ns", s, "ns", false);
+        record("tlb.4k_step." + to_string(n) + "pages." + hk + ".latency_ns", h, "ns", false);
+        prevS = s;
+        prevH = h;
+    }
+
+    // The huge-step walk takes what is left of the hugetlb pool (the 4 KB-step
+    // buffer above is already faulted in).
+    PageKind stepKind = hugeKind;
+    size_t freePages = free_hugetlb_pages(stepKind);
+    if (freePages < maxHugePages && freePages >= kTlbMinPages)
+    {
+        cerr << "note: --tlb-huge-pages " << maxHugePages << " capped to the " << freePages
+             << " free " << page_kind_name(stepKind) << " pages\n";
+        maxHugePages = freePages;
+    }
+    else if (freePages < maxHugePages)
+    {
+        cerr << "warning: only " << freePages << " free " << page_kind_name(stepKind)
+             << " pages, using thp for the huge-page steps\n";
+        stepKind = PageKind::THP;
+    }
+    size_t hugeStep = page_bytes(stepKind);
+    Buffer big = alloc_buffer(maxHugePages * hugeStep, stepKind);
+    if (!big.p && stepKind != PageKind::THP)
+    {
+        cerr << "warning: " << page_kind_name(stepKind) << " pages unavailable, using thp\n";
+        stepKind = PageKind::THP;
+        hugeStep = page_bytes(stepKind);
+        big = alloc_buffer(maxHugePages * hugeStep, stepKind);
+    }
+    if (!big.p)
+    {
+        cerr << "--tlb: buffer allocation failed\n";
+        free_buffer(small);
+        free_buffer(huge);
+        return;
+    }
+    touch_pages(big.p, big.bytes);
+    const string sk = page_kind_name(stepKind);
+
+    cout << "TLB reach, one line per " << (hugeStep >> 10) << " KB " << sk << " page\n";
+    cout << right << setw(10) << "pages" << setw(10) << "span_MB" << setw(12) << "ns" << "\n";
+    double prev = 0;
+    for (size_t n : tlb_page_counts(maxHugePages))
+    {
+        double h = tlb_chase_ns(big.p, n, hugeStep, iters).value;
+        cout << right << setw(10) << n << fixed << setprecision(0) << setw(10)
+             << (double)(n * hugeStep) / 1048576.0 << setprecision(2) << setw(12) << h
+             << tlb_knee(prev, h) << endl;
+        record("tlb.huge_step." + to_string(n) + "pages." + sk + ".latency_ns", h, "ns", false);
+        prev = h;
+    }
+
+    free_buffer(small);
+    free_buffer(huge);
+    free_buffer(big);
+}
+
+//====================================================
+// Associativity and set conflicts (--assoc)
+//====================================================
+// N lines spaced a power-of-two stride apart share the same sets in every
+// cache whose way size (capacity / ways) divides the stride, so the chase
+// latency steps up once N exceeds that level's associativity: the knee at
+// stride = way size gives the effective ways, and whether the knee survives
+// at twice the stride tells modulo indexing from hashed (sliced) indexing.
+// The buffer uses THP so physically-indexed levels see the virtual strides.
+
+// Sets of `L` a chase with this stride visits (0 = unknown geometry).
+static size_t stride_sets(const CacheLevel& L, size_t stride)
+{
+    if (!L.ways || !L.line) return 0;
+    size_t sets = L.bytes / ((size_t)L.ways * L.line);
+    if (!sets || (sets & (sets - 1))) return 0;
+    size_t step = stride / L.line;
+    if (stride % L.line || !step) return sets;
+    return sets / min(step & (~step + 1), sets);
+}
+
+// Warns when --stride leaves the latency chain in a small fraction of the
+// sets of a level, where it measures conflict misses instead of capacity.
+static void warn_stride_aliasing(size_t stride)
+{
+    const CacheInfo& C = cache_info();
+    const pair<const char*, const CacheLevel*> levels[] = { { "L1d", &C.l1 }, { "L2", &C.l2 } };
+    for (const auto& e : levels)
+    {
+        size_t sets = stride_sets(*e.second, 0);
+        size_t used = stride_sets(*e.second, stride);
+        if (!sets || used * 8 > sets) continue;
+        cerr << "warning: --stride " << stride << " maps the latency chain onto " << used
+             << " of " << sets << " " << e.first << " sets (" << used * e.second->ways
+             << " lines); results will be dominated by conflict misses\n";
+    }
+}
+
+// Latency for n = 1..maxN lines `stride` apart, visited in random order.
+static vector<double> assoc_curve(char* buf, size_t stride, int maxN, int iters)
+{
+    vector<double> lat(maxN + 1, 0.0);
+    mt19937_64 rng(1234567);
+    for (int n = 1; n <= maxN; ++n)
+    {
+        vector<size_t> offs(n);
+        for (int i = 0; i < n; ++i) offs[i] = (size_t)i * stride;
+        shuffle(offs.begin(), offs.end(), rng);
+        lat[n] = chase_latency(link_ring(buf, offs), iters).value;
+    }
+    return lat;
+}
+
+// Returns n where latency rises >25% (and >0.5 ns) over n - 1. Replacement
+// policies often smear a step over two adjacent n; such runs are merged into
+// the n with the larger jump.
+static vector<int> assoc_knees(const vector<double>& lat)
+{
+    vector<int> k;
+    for (size_t n = 2; n < lat.size(); ++n)
+    {
+        if (!(lat[n] > lat[n - 1] * 1.25 && lat[n] - lat[n - 1] > 0.5)) continue;
+        if (!k.empty() && (size_t)k.back() == n - 1)
+        {
+            if (lat[n] - lat[n - 1] > lat[n - 1] - lat[n - 2]) k.back() = (int)n;
+            continue;
+        }
+        k.push_back((int)n);
+    }
+    return k;
+}
+
+static void runAssoc(size_t maxStride, int maxN, int iters)
+{
+    const CacheInfo& C = cache_info();
+    const pair<const char*, const CacheLevel*> levels[] = {
+        { "L1d", &C.l1 }, { "L2", &C.l2 }, { "L3", &C.l3 } };
+    if (maxN <= 0)
+        maxN = min(64, 2 * max(max(C.l1.ways, C.l2.ways), max(C.l3.ways, 16)) + 2);
+
+    Buffer b = alloc_buffer((size_t)maxN * maxStride + kLine, PageKind::THP);
+    if (!b.p) b = alloc_buffer((size_t)maxN * maxStride + kLine, PageKind::Default);
+    if (!b.p)
+    {
+        cerr << "--assoc: buffer allocation failed\n";
+        return;
+    }
+    touch_pages(b.p, b.bytes);
+
+    cout << "Set conflicts: 1.." << maxN << " lines at power-of-two strides ["
+         << describe_pages(b) << "]  knees = N where latency steps up\n";
+    cout << right << setw(10) << "stride_B" << setw(10) << "N=1_ns" << "  knees (N: ns)\n";
+    vector<pair<size_t, vector<int>>> knees;
+    for (size_t s = 1024; s <= maxStride; s *= 2)
+    {
+        vector<double> lat = assoc_curve(b.p, s, maxN, iters);
+        vector<int> k = assoc_knees(lat);
+        cout << right << setw(10) << s << fixed << setprecision(2) << setw(10) << lat[1] << " ";
+        for (int n : k) cout << "  " << n << ": " << lat[n];
+        if (k.empty()) cout << "  -";
+        cout << endl;
+        string key = "assoc." + to_string(s) + "B";
+        record(key + ".first_knee_n", k.empty() ? 0.0 : (double)k[0], "lines", true);
+        record(key + ".n" + to_string(maxN) + ".latency_ns", lat[maxN], "ns", false);
+        knees.push_back({ s, k });
+    }
+
+    auto at = [&](size_t s) -> const vector<int>*
+    {
+        for (const auto& e : knees)
+            if (e.first == s) return &e.second;
+        return nullptr;
+    };
+
+    // Level i conflicts together with every smaller level whose way size
+    // divides its own, so its knee is the (that count)-th one at its stride.
+    cout << "Associativity (" << C.source << " geometry vs. measured):\n";
+    for (size_t i = 0; i < 3; ++i)
+    {
+        const CacheLevel& L = *levels[i].second;
+        if (!L.bytes) continue;
+        cout << "  " << left << setw(4) << levels[i].first << right << setw(8) << (L.bytes >> 10)
+             << " KB ";
+        if (!L.ways)
+        {
+            cout << " ways unknown\n";
+            continue;
+        }
+        size_t span = L.bytes / L.ways;
+        cout << setw(3) << L.ways << "-way, way size " << (span >> 10) << " KB: ";
+        const vector<int>* k = at(span);
+        if ((span & (span - 1)) || !k)
+        {
+            cout << ((span & (span - 1)) ? "not a power of two (sliced / hashed index)"
+                                         : "way size beyond --assoc-max-stride")
+                 << "\n";
+            continue;
+        }
+        size_t idx = 0;
+        for (size_t j = 0; j < i; ++j)
+        {
+            const CacheLevel& P = *levels[j].second;
+            if (P.ways && span % (P.bytes / P.ways) == 0) ++idx;
+        }
+        if (idx >= k->size())
+        {
+            cout << "no conflict knee up to N=" << maxN << " (hashed index or ways > "
+                 << maxN - 1 << ")\n";
+            continue;
+        }
+        int ways = (*k)[idx] - 1;
+        const vector<int>* k2 = at(span * 2);
+        bool modulo = k2 && idx < k2->size() && (*k2)[idx] == (*k)[idx];
+        cout << ways << " effective ways" << (ways != L.ways ? " (differs)" : "")
+             << (k2 ? (modulo ? ", modulo set index" : ", hashed set index") : "") << "\n";
+        record(string("assoc.") + levels[i].first + ".effective_ways", ways, "ways", true);
+    }
+    free_buffer(b);
+}
+
+//====================================================
+// Page-size latency comparison
+//====================================================
+// Re-runs the latency chain of every tier on `other` (normal pages when the
+// main buffers are huge, THP when they are 4 KB) to expose the TLB share.
+static void runPageCompare(const Buffer& main, const Buffer& other,
+                           const vector<pair<const char*, size_t>>& tiers, size_t stride)
+{
+    cout << "Page-size latency comparison (ns): " << page_kind_name(main.kind)
+         << " [" << describe_pages(main) << "] vs " << page_kind_name(other.kind)
+         << " [" << describe_pages(other) << "]\n";
+    cout << left << setw(8) << "Tier" << right << setw(12) << page_kind_name(main.kind)
+         << setw(12) << page_kind_name(other.kind) << setw(10) << "delta" << "\n";
+    for (const auto& t : tiers)
+    {
+        size_t bytes = t.second * 1024ULL;
+        double a = latency_ns(main.p, bytes, stride).value;
+        double b = latency_ns(other.p, bytes, stride).value;
+        cout << left << setw(8) << t.first << right << fixed << setprecision(2)
+             << setw(12) << a << setw(12) << b << setw(9) << (b - a) / a * 100.0 << "%\n";
+        string key = string("pages.") + t.first;
+        record(key + "." + page_kind_name(main.kind) + ".latency_ns", a, "ns", false);
+        record(key + "." + page_kind_name(other.kind) + ".latency_ns", b, "ns", false);
+    }
+}
+
+//====================================================
+// Machine-readable report and baseline comparison
+//====================================================
+static string json_escape(const string& s)
+{
+    string o;
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\') { o += '\\'; o += c; }
+        else if ((unsigned char)c < 0x20) { char b[8]; snprintf(b, sizeof(b), "\\u%04x", c); o += b; }
+        else o += c;
+    }
+    return o;
+}
+
+static string cpu_model()
+{
+#if defined(__linux__)
+    FILE* f = fopen("/proc/cpuinfo", "r");
+    char line[512];
+    string model;
+    while (f && fgets(line, sizeof(line), f))
+    {
+        string l(line);
+        if (l.rfind("model name", 0) == 0 || l.rfind("Model", 0) == 0 || l.rfind("Hardware", 0) == 0)
+        {
+            size_t c = l.find(':');
+            if (c != string::npos) model = l.substr(c + 2);
+            while (!model.empty() && model.back() == '\n') model.pop_back();
+            break;
+        }
+    }
+    if (f) fclose(f);
+    if (!model.empty()) return model;
+#elif defined(__APPLE__)
+    char buf[256];
+    size_t len = sizeof(buf);
+    if (sysctlbyname("machdep.cpu.brand_string", buf, &len, nullptr, 0) == 0) return buf;
+#endif
+    struct utsname u;
+    return uname(&u) == 0 ? u.machine : "unknown";
+}
+
+// Compiler flags are not visible at run time; -DCB_CFLAGS="..." records them,
+// otherwise the ISA macros the build was compiled for are listed.
+static string build_flags()
+{
+#if defined(CB_CFLAGS)
+    return CB_CFLAGS;
+#else
+    string f;
+#if defined(__OPTIMIZE__)
+    f += "optimized ";
+#endif
+#if defined(__AVX512F__)
+    f += "avx512f ";
+#endif
+#if defined(__AVX2__)
+    f += "avx2 ";
+#endif
+#if defined(__ARM_NEON)
+    f += "neon ";
+#endif
+    if (!f.empty()) f.pop_back();
+    return f;
+#endif
+}
+
+static vector<pair<string, string>> host_metadata(const Args& A)
+{
+    struct utsname u;
+    string kernel = uname(&u) == 0 ? string(u.sysname) + " " + u.release : "unknown";
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+    const CacheInfo& C = cache_info();
+    return {
+        { "hostname", host },
+        { "cpu", cpu_model() },
+        { "cpus", to_string(online_cpus().size()) },
+        { "kernel", kernel },
+        { "compiler", __VERSION__ },
+        { "flags", build_flags() },
+        { "l1d_kb", to_string(C.l1.bytes >> 10) },
+        { "l2_kb", to_string(C.l2.bytes >> 10) },
+        { "l3_kb", to_string(C.l3.bytes >> 10) },
+        { "cache_source", C.source },
+        { "bench_kernel", g_kernel->name },
+        { "timer", g_timer.name },
+        { "threads", to_string(A.threads) },
+        { "pages", page_kind_name(A.pages) },
+    };
+}
+
+// inf / nan (a zero-time sample, an empty Stats) are not JSON numbers;
+// they are written as null (empty in CSV) and read back as 0, which
+// --compare skips.
+static void put_number(ostream& o, double v, int precision, const char* missing)
+{
+    if (isfinite(v)) o << setprecision(precision) << defaultfloat << v;
+    else o << missing;
+}
+
+static void writeJson(ostream& o, const Args& A)
+{
+    o << "{\n  \"host\": {";
+    bool first = true;
+    for (const auto& kv : host_metadata(A))
+    {
+        o << (first ? "\n" : ",\n") << "    \"" << kv.first << "\": \"" << json_escape(kv.second) << "\"";
+        first = false;
+    }
+    o << "\n  },\n  \"metrics\": {";
+    first = true;
+    for (const Metric& m : g_metrics)
+    {
+        o << (first ? "\n" : ",\n") << "    \"" << json_escape(m.key) << "\": { \"value\": ";
+        put_number(o, m.value, 6, "null");
+        o << ", \"unit\": \"" << m.unit << "\", \"higher_is_better\": "
+          << (m.higherIsBetter ? "true" : "false") << ", \"cv_pct\": ";
+        put_number(o, m.cvPct, 3, "null");
+        o << " }";
+        first = false;
+    }
+    o << "\n  }\n}\n";
+}
+
+static void writeCsv(ostream& o, const Args& A)
+{
+    o << "key,value,unit,higher_is_better,cv_pct\n";
+    for (const auto& kv : host_metadata(A))
+    {
+        string v = kv.second;
+        replace(v.begin(), v.end(), ',', ';');
+        o << "host." << kv.first << "," << v << ",,,\n";
+    }
+    for (const Metric& m : g_metrics)
+    {
+        o << m.key << ",";
+        put_number(o, m.value, 6, "");
+        o << "," << m.unit << "," << (m.higherIsBetter ? 1 : 0) << ",";
+        put_number(o, m.cvPct, 3, "");
+        o << "\n";
+    }
+}
+
+// Reads the "metrics" object of a JSON report written by writeJson.
+static bool loadBaseline(const string& path, vector<Metric>& out)
+{
+    FILE* f = fopen(path.c_str(), "r");
+    if (!f) return false;
+    string s;
+    char buf[4096];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) s.append(buf, n);
+    fclose(f);
+
+    size_t pos = s.find("\"metrics\"");
+    if (pos == string::npos) return false;
+    pos = s.find('{', pos);
+    while (pos != string::npos)
+    {
+        size_t k0 = s.find('"', pos + 1);
+        if (k0 == string::npos) break;
+        size_t k1 = s.find('"', k0 + 1);
+        size_t body = s.find('{', k1);
+        size_t end = s.find('}', body);
+        if (k1 == string::npos || body == string::npos || end == string::npos) break;
+
+        Metric m{ s.substr(k0 + 1, k1 - k0 - 1), 0, "", true, 0 };
+        string obj = s.substr(body, end - body);
+        auto field = [&](const char* name) -> const char*
+        {
+            size_t p = obj.find(string("\"") + name + "\"");
+            if (p == string::npos) return nullptr;
+            p = obj.find(':', p);
+            return p == string::npos ? nullptr : obj.c_str() + p + 1;
+        };
+        if (const char* v = field("value")) m.value = strtod(v, nullptr);
+        if (const char* v = field("cv_pct")) m.cvPct = strtod(v, nullptr);
+        if (const char* v = field("higher_is_better")) m.higherIsBetter = strstr(v, "true") == v + strspn(v, " ");
+        out.push_back(m);
+
+        pos = end + 1;
+        while (pos < s.size() && (isspace((unsigned char)s[pos]) || s[pos] == ',')) ++pos;
+        if (pos >= s.size() || s[pos] == '}') break;
+        --pos;
+    }
+    return true;
+}
+
+// Diffs every current metric against the baseline. A metric regresses when
+// it moves the wrong way by more than its tolerance: --tolerance, widened to
+// 3x the noisier run's CV. Returns the number of regressions.
+static int compareBaseline(const vector<Metric>& base, double tolPct)
+{
+    int regressions = 0, matched = 0;
+    cout << "Baseline comparison (tolerance " << fixed << setprecision(1) << tolPct << "%)\n";
+    cout << left << setw(32) << "metric" << right << setw(12) << "baseline" << setw(12) << "current"
+         << setw(9) << "delta" << setw(8) << "tol" << "  status\n";
+    for (const Metric& m : g_metrics)
+    {
+        auto it = find_if(base.begin(), base.end(), [&](const Metric& b) { return b.key == m.key; });
+        if (it == base.end() || it->value == 0 || !isfinite(m.value)) continue;
+        ++matched;
+        double delta = (m.value - it->value) / fabs(it->value) * 100.0;
+        double tol = max(tolPct, 3.0 * max(m.cvPct, it->cvPct));
+        double worse = m.higherIsBetter ? -delta : delta;
+        const char* status = worse > tol ? "REGRESSED" : (-worse > tol ? "improved" : "ok");
+        if (worse > tol) ++regressions;
+        cout << left << setw(32) << m.key << right << setprecision(2) << setw(12) << it->value
+             << setw(12) << m.value << setw(8) << setprecision(1) << delta << "%" << setw(7) << tol
+             << "%  " << status << "\n";
+    }
+    cout << matched << " metrics compared, " << regressions << " regressed\n";
+    return regressions;
+}
+
+//====================================================
+// Monitor mode (--monitor)
+//====================================================
+// Re-probes latency and single-thread read bandwidth over the same buffer
+// and pointer ring every --monitor-interval seconds until SIGINT/SIGTERM or
+// --monitor-count probes. Each probe's per-metric time budget is a quarter
+// of the CPU budget, and the next probe is deferred until the process CPU
+// time stays within --monitor-budget percent of wall time since start.
+static volatile sig_atomic_t g_stop = 0;
+
+static void on_stop_signal(int)
+{
+    g_stop = 1;
+}
+
+static double process_cpu_sec()
+{
+    timespec ts;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &ts);
+    return (double)ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static string utc_timestamp(time_t t)
+{
+    tm u;
+    gmtime_r(&t, &u);
+    char b[32];
+    strftime(b, sizeof(b), "%Y-%m-%dT%H:%M:%SZ", &u);
+    return b;
+}
+
+struct MonitorSample
+{
+    time_t when = 0;
+    double latencyNs = 0;
+    double readGBs = 0;
+    double probeSec = 0;            // wall time of the probe
+    double cpuPct = 0;              // process CPU / wall since start
+    uint64_t seq = 0;
+};
+
+static void write_monitor_jsonl(ostream& o, const MonitorSample& s, const string& host, size_t KB)
+{
+    o << "{\"ts\": \"" << utc_timestamp(s.when) << "\", \"unix\": " << (long long)s.when
+      << ", \"host\": \"" << json_escape(host) << "\", \"seq\": " << s.seq << ", \"kb\": " << KB
+      << setprecision(6) << defaultfloat << ", \"latency_ns\": " << s.latencyNs
+      << ", \"read_gbs\": " << s.readGBs << ", \"probe_sec\": " << s.probeSec
+      << ", \"cpu_pct\": " << s.cpuPct << "}" << endl;
+}
+
+// node_exporter textfile collector format; written to a temp file and
+// renamed so the collector never reads a partial file.
+static bool write_monitor_prom(const string& path, const MonitorSample& s, size_t KB)
+{
+    string tmp = path + ".tmp";
+    ofstream f(tmp);
+    if (!f) return false;
+    const string lbl = "{kb=\"" + to_string(KB) + "\",kernel=\"" + g_kernel->name + "\"}";
+    auto gauge = [&](const char* name, const char* help, double v)
+    {
+        f << "# HELP " << name << " " << help << "\n# TYPE " << name << " gauge\n"
+          << name << lbl << " " << setprecision(10) << defaultfloat << v << "\n";
+    };
+    gauge("cachebench_latency_ns", "Dependent-load latency over the probe buffer.", s.latencyNs);
+    gauge("cachebench_read_gbs", "Single-thread read bandwidth over the probe buffer.", s.readGBs);
+    gauge("cachebench_probe_seconds", "Wall time of the last probe.", s.probeSec);
+    gauge("cachebench_cpu_percent", "Process CPU time as a percentage of wall time.", s.cpuPct);
+    gauge("cachebench_last_probe_timestamp_seconds", "Unix time of the last probe.",
+          (double)s.when);
+    f << "# HELP cachebench_probes_total Probes taken since start.\n"
+         "# TYPE cachebench_probes_total counter\ncachebench_probes_total" << lbl << " "
+      << s.seq << "\n";
+    f.close();
+    return f.good() && rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+static void runMonitor(ostream& out, char* buf, size_t KB, size_t stride, double intervalSec,
+                       uint64_t count, double budgetPct, int niceness, const string& format,
+                       const string& path)
+{
+    signal(SIGINT, on_stop_signal);
+    signal(SIGTERM, on_stop_signal);
+    if (niceness && setpriority(PRIO_PROCESS, 0, niceness) != 0)
+        cerr << "warning: setpriority(" << niceness << ") failed: " << strerror(errno) << "\n";
+
+    size_t bytes = KB * 1024ULL;
+    double budget = min(max(budgetPct, 0.01), 100.0) / 100.0;
+    g_adapt.targetSec = budget * intervalSec / 4;
+    char* head = build_chains(buf, bytes, stride)[0];
+    char host[256] = "unknown";
+    gethostname(host, sizeof(host) - 1);
+
+    ofstream file;
+    if (format == "jsonl" && !path.empty())
+    {
+        file.open(path, ios::app);
+        if (!file)
+        {
+            cerr << "Cannot open " << path << "\n";
+            return;
+        }
+    }
+    ostream& o = file.is_open() ? file : out;
+
+    cout << "Monitor: " << KB << " KB, every " << intervalSec << " s, CPU budget "
+         << budget * 100 << "%, " << (format == "prom" ? "prometheus textfile " + path
+                                                       : "json lines")
+         << " (Ctrl-C to stop)" << endl;
+
+    auto t0 = clk::now();
+    double cpu0 = process_cpu_sec();
+    MonitorSample s;
+    while (!g_stop && (count == 0 || s.seq < count))
+    {
+        auto p0 = clk::now();
+        s.latencyNs = chase_latency(head, 1).value;
+        s.readGBs = bw_read_gbs(buf, bytes, 1).value;
+        auto p1 = clk::now();
+        s.when = time(nullptr);
+        s.probeSec = chrono::duration<double>(p1 - p0).count();
+        double wall = chrono::duration<double>(p1 - t0).count();
+        double cpu = process_cpu_sec() - cpu0;
+        s.cpuPct = wall > 0 ? 100.0 * cpu / wall : 0;
+        ++s.seq;
+        if (format == "prom")
+        {
+            if (!write_monitor_prom(path, s, KB)) cerr << "Cannot write " << path << "\n";
+        }
+        else write_monitor_jsonl(o, s, host, KB);
+
+        // Next probe at the interval, or later if the CPU budget needs it.
+        double next = max((double)s.seq * intervalSec, cpu / budget);
+        while (!g_stop && (count == 0 || s.seq < count) &&
+               chrono::duration<double>(clk::now() - t0).count() < next)
+            this_thread::sleep_for(chrono::milliseconds(100));
+    }
+}
+
+//====================================================
+// Suite scheduler (--only, --skip, --all, --time-budget)
+//====================================================
+// Every requested suite runs in catalog order on one shared arena (sized
+// for the largest of them). Each suite carries a rough cost model: its
+// number of adaptive metrics times the per-metric budget plus the chain
+// shuffles it needs. The model is rescaled after every suite by the
+// measured/estimated ratio, so the ETA converges as the run goes. Suites
+// whose estimate no longer fits in --time-budget are skipped.
+// With --pipeline an idle core shuffles the latency-ring orders of the next
+// suite while the current one runs. The orders are the same (same seed), but
+// the shuffle competes for the shared LLC and DRAM bandwidth, so it can
+// lower L3 / Memory numbers; it is off by default.
+struct Suite
+{
+    const char* name;
+    bool requested;
+    double units;                   // adaptive metrics it takes
+    size_t arenaKB;                 // buf1/buf2 size it needs
+    vector<size_t> rings;           // build_chains node counts to prepare
+    function<bool()> run;
+};
+
+static string fmt_duration(double sec)
+{
+    long s = (long)llround(max(sec, 0.0));
+    char b[32];
+    if (s >= 3600) snprintf(b, sizeof(b), "%ldh%02ldm", s / 3600, s / 60 % 60);
+    else if (s >= 60) snprintf(b, sizeof(b), "%ldm%02lds", s / 60, s % 60);
+    else snprintf(b, sizeof(b), "%lds", s);
+    return b;
+}
+
+static double suite_estimate(const Suite& s)
+{
+    double nodes = 0;
+    for (size_t n : s.rings) nodes += (double)n;
+    return s.units * g_adapt.targetSec * 1.3 + nodes * 100e-9;
+}
+
+// Applies --only / --skip; unknown names are an error.
+static bool select_suites(vector<Suite>& suites, const string& only, const string& skip)
+{
+    auto names = [](const string& list)
+    {
+        vector<string> v;
+        for (size_t i = 0; i < list.size();)
+        {
+            size_t end = list.find(',', i);
+            if (end == string::npos) end = list.size();
+            if (end > i) v.push_back(list.substr(i, end - i));
+            i = end + 1;
+        }
+        return v;
+    };
+    auto find_suite = [&](const string& n) -> Suite*
+    {
+        for (Suite& s : suites)
+            if (n == s.name) return &s;
+        cerr << "Unknown suite '" << n << "'; suites:";
+        for (const Suite& s : suites) cerr << " " << s.name;
+        cerr << "\n";
+        return nullptr;
+    };
+    vector<string> o = names(only), k = names(skip);
+    if (!o.empty())
+    {
+        for (Suite& s : suites) s.requested = false;
+        for (const string& n : o)
+        {
+            Suite* s = find_suite(n);
+            if (!s) return false;
+            s->requested = true;
+        }
+    }
+    for (const string& n : k)
+    {
+        Suite* s = find_suite(n);
+        if (!s) return false;
+        s->requested = false;
+    }
+    return true;
+}
+
+// Returns the number of suites that failed. Banners with the ETA are only
+// printed when more than one suite runs or a budget is set, so single-suite
+// output is unchanged.
+static int runSuites(vector<Suite>& suites, double budgetSec, bool pipeline, int busyThreads)
+{
+    vector<Suite*> todo;
+    for (Suite& s : suites)
+        if (s.requested) todo.push_back(&s);
+    if (todo.empty())
+    {
+        cerr << "No suites selected\n";
+        return 0;
+    }
+    bool banner = todo.size() > 1 || budgetSec > 0;
+    const vector<int>& cpus = online_cpus();
+    bool idleCore = pipeline && (int)cpus.size() > max(1, busyThreads);
+
+    auto t0 = clk::now();
+    double estDone = 0, actDone = 0;
+    int failed = 0, skipped = 0;
+    thread prep;
+    for (size_t i = 0; i < todo.size(); ++i)
+    {
+        if (prep.joinable()) prep.join();
+        double ratio = estDone > 0 ? min(max(actDone / estDone, 0.1), 10.0) : 1.0;
+        double elapsed = chrono::duration<double>(clk::now() - t0).count();
+        double est = suite_estimate(*todo[i]) * ratio, left = 0;
+        for (size_t j = i; j < todo.size(); ++j) left += suite_estimate(*todo[j]) * ratio;
+        if (budgetSec > 0 && elapsed + est > budgetSec)
+        {
+            cout << "== " << todo[i]->name << ": skipped, estimate " << fmt_duration(est)
+                 << " exceeds the remaining --time-budget\n";
+            ++skipped;
+            continue;
+        }
+        if (banner)
+            cout << "== [" << i + 1 << "/" << todo.size() << "] " << todo[i]->name << " (est "
+                 << fmt_duration(est) << ", elapsed " << fmt_duration(elapsed) << ", ETA "
+                 << fmt_duration(left) << ")" << endl;
+
+        if (idleCore && i + 1 < todo.size() && !todo[i + 1]->rings.empty())
+        {
+            vector<size_t> rings = todo[i + 1]->rings;
+            prep = thread([rings, &cpus]
+            {
+                pin_thread(cpus.back());
+                prepare_slots(rings);
+            });
+        }
+
+        auto s0 = clk::now();
+        if (!todo[i]->run()) ++failed;
+        actDone += chrono::duration<double>(clk::now() - s0).count();
+        estDone += suite_estimate(*todo[i]);
+    }
+    if (prep.joinable()) prep.join();
+    clear_slots();
+    if (banner)
+        cout << "== " << todo.size() - skipped << " suite(s) in "
+             << fmt_duration(chrono::duration<double>(clk::now() - t0).count())
+             << (skipped ? ", " + to_string(skipped) + " skipped" : string()) << "\n";
+    return failed;
+}
+
+//====================================================
+// Main
+//====================================================
+int main(int argc, char** argv) 
 {
     Args A;
     if (!parse(argc, argv, A)) return 1;
 
-    const size_t align = 1ULL << 21; // 2 MB
-    size_t maxKB = max(max(A.l3KB, A.memKB), max(A.l2KB, A.l1KB));
-    size_t totalBytes = maxKB * 1024ULL + align;
+    // Machine formats and --monitor own stdout; the human-readable text goes to stderr.
+    streambuf* stdoutBuf = cout.rdbuf();
+    if (A.format != "text" || A.monitor) cout.rdbuf(cerr.rdbuf());
+
+    vector<Metric> baseline;
+    if (!A.compare.empty() && !loadBaseline(A.compare, baseline))
+    {
+        cerr << "Cannot read baseline " << A.compare << "\n";
+        return 1;
+    }
+
+    g_adapt.targetSec = A.targetMs / 1e3;
+    g_adapt.ci = max(A.ciPct, 0.0) / 100.0;
+    g_stream.on = A.stream;
+    g_stream.rw = A.rwRatios;
+
+    if (!init_timer(A.timer, A.cycles))
+    {
+        cerr << "Timer '" << A.timer << "' is not available on this CPU/build\n";
+        return 1;
+    }
+
+    g_kernel = find_kernel(A.kernel);
+    if (!g_kernel)
+    {
+        cerr << "Kernel '" << A.kernel << "' is not available on this CPU/build\n";
+        return 1;
+    }
+
+    if (A.listKernels)
+    {
+        cout.rdbuf(stdoutBuf);
+        listKernels();
+        return 0;
+    }
+    vector<const TKernel*> tks;
+    if (!A.tkernel.empty() && !select_tkernels(A.tkernel, tks)) return 1;
+
+    // Catalog order is run order. Without suite flags (or --only / --all)
+    // the tier table runs, as it always has.
+    const vector<pair<const char*, size_t>> tiers = {
+        { "L1", A.l1KB }, { "L2", A.l2KB }, { "L3", A.l3KB }, { "Memory", A.memKB } };
+    size_t tierKB = max(max(A.l3KB, A.memKB), max(A.l2KB, A.l1KB));
+    auto ring = [&](size_t KB) { return max<size_t>(2, KB * 1024ULL / A.stride); };
+    vector<size_t> tierRings = { ring(A.memKB), ring(A.l1KB), ring(A.l2KB), ring(A.l3KB) };
+    vector<size_t> sweepRings;
+    for (size_t kb : sweep_sizes_kb(A.sweepMinKB, A.sweepMaxKB, A.ppo)) sweepRings.push_back(ring(kb));
+    bool tkLatency = false;
+    for (const TKernel* k : tks) tkLatency = tkLatency || k->chase;
+    const size_t nNodes = max<size_t>(1, numa_nodes().size());
+
+    vector<int> c2cCpus;
+    {
+        const vector<int>& allowed = online_cpus();
+        for (int c : A.c2cCpus.empty() ? allowed : parse_list(A.c2cCpus))
+            if (find(allowed.begin(), allowed.end(), c) != allowed.end() &&
+                find(c2cCpus.begin(), c2cCpus.end(), c) == c2cCpus.end())
+                c2cCpus.push_back(c);
+    }
+
+    size_t totalBytes = 0;
+    Buffer b1, b2;
+    char* buf1 = nullptr;
+    char* buf2 = nullptr;
+    int rwCount = (int)A.rwRatios.size();
+    vector<Suite> suites = {
+        { "tiers", false, 4.0 * (6 + (A.stream ? 4 + rwCount : 0)) + (A.pages != PageKind::Default ? 8 : 0),
+          tierKB * (A.stream ? (size_t)max(1, A.threads) : 1), tierRings, [&]
+        {
+            Row mem = benchTier("Memory", A.memKB, buf1, buf2, A.iters, A.stride, A.threads);
+            Row l1  = benchTier("L1", A.l1KB, buf1, buf2, A.iters, A.stride, A.threads);
+            Row l2  = benchTier("L2", A.l2KB, buf1, buf2, A.iters, A.stride, A.threads);
+            Row l3  = benchTier("L3", A.l3KB, buf1, buf2, A.iters, A.stride, A.threads);
+
+            printRow("Memory", mem);
+            printRow("L1", l1);
+            printRow("L2", l2);
+            printRow("L3", l3);
+            recordRow("Memory", mem);
+            recordRow("L1", l1);
+            recordRow("L2", l2);
+            recordRow("L3", l3);
+            if (anyUnstable(mem) || anyUnstable(l1) || anyUnstable(l2) || anyUnstable(l3))
+                cout << "* unstable: sample CV above " << kUnstableCV * 100 << "%\n";
+            if (A.stats)
+            {
+                printStats("Memory", mem);
+                printStats("L1", l1);
+                printStats("L2", l2);
+                printStats("L3", l3);
+            }
+            printCounters("Memory", mem);
+            printCounters("L1", l1);
+            printCounters("L2", l2);
+            printCounters("L3", l3);
+            printRdt("Memory", mem);
+            printRdt("L1", l1);
+            printRdt("L2", l2);
+            printRdt("L3", l3);
+
+            if (A.pages != PageKind::Default)
+            {
+                PageKind otherKind = (A.pages == PageKind::Small) ? PageKind::THP : PageKind::Small;
+                Buffer other = alloc_buffer(totalBytes, otherKind);
+                if (other.p)
+                {
+                    for (size_t off = 0; off < other.bytes; off += 4096) other.p[off] = 1;
+                    runPageCompare(b1, other, { { "Memory", A.memKB }, { "L1", A.l1KB },
+                                                { "L2", A.l2KB }, { "L3", A.l3KB } }, A.stride);
+                    free_buffer(other);
+                }
+            }
+            return true;
+        } },
+        { "sweep", A.sweep, 6.0 * sweepRings.size(),
+          A.sweepMaxKB * (A.stream ? (size_t)max(1, A.threads) : 1), sweepRings, [&]
+        {
+            runSweep(buf1, buf2, A.sweepMinKB, A.sweepMaxKB, A.ppo, A.iters, A.stride, A.threads);
+            return true;
+        } },
+        { "mlp", A.mlp, (double)A.mlpMax, A.mlpKB, { ring(A.mlpKB) }, [&]
+        {
+            runMLP(buf1, A.mlpKB, A.stride, A.mlpMax);
+            return true;
+        } },
+        { "numa", A.numa, 4.0 * nNodes * nNodes, 4, {}, [&]
+        {
+            runNuma(A.numaKB, A.stride, A.iters, A.pages);
+            return true;
+        } },
+        { "patterns", A.patterns, 40, tierKB, {}, [&]
+        {
+            runPatterns(buf1, tiers, A.patternStride, A.iters);
+            return true;
+        } },
+        { "copy", A.copy, 600.0 + 20.0 * parse_list(A.copyMisalign).size(),
+          max(A.copyMaxKB, A.copyAlignSize / 1024 + 1), {}, [&]
+        {
+            runCopy(buf1, buf2, A.copyMaxKB * 1024ULL, A.copyAlignSize, parse_list(A.copyMisalign),
+                    A.iters);
+            return true;
+        } },
+        { "structs", A.structs, 32, tierKB, {}, [&]
+        {
+            runStructs(buf1, tiers, A.iters);
+            return true;
+        } },
+        { "layout", A.layout, 36, tierKB, {}, [&]
+        {
+            runLayout(buf1, tiers, A.layoutFields, A.layoutFieldBytes, A.layoutBlock, A.iters);
+            return true;
+        } },
+        { "alloc", A.alloc, 12, 4, {}, [&]
+        {
+            runAlloc(A.allocOps ? A.allocOps : (A.quick ? 50000 : 200000), A.iters);
+            return true;
+        } },
+        { "faults", A.faults, 20, 4, {}, [&]
+        {
+            int threads = A.threads > 1 ? A.threads : (int)online_cpus().size();
+            runFaults(A.faultMB ? A.faultMB : (A.quick ? 256 : 1024), threads, A.iters);
+            return true;
+        } },
+        { "assoc", A.assoc, 40.0 * (log2((double)A.assocMaxStride / 1024) + 1), 4, {}, [&]
+        {
+            runAssoc(A.assocMaxStride, A.assocMaxN, A.iters);
+            return true;
+        } },
+        { "tlb", A.tlb, 2.0 * tlb_page_counts(A.tlbPages).size() +
+                        tlb_page_counts(A.tlbHugePages).size(), 4, {}, [&]
+        {
+            PageKind huge = (A.pages == PageKind::Huge2M || A.pages == PageKind::Huge1G)
+                                ? A.pages : PageKind::THP;
+            runTlb(A.tlbPages, A.tlbHugePages, huge, A.iters);
+            return true;
+        } },
+        { "io", !A.ioPath.empty(), 10, 4, {}, [&]
+        {
+            runIo(A.ioPath, A.ioMB, A.ioMB ? A.ioMB : (A.quick ? 64 : 256), A.iters);
+            return true;
+        } },
+        { "atomics", A.atomics, 60, tierKB, {}, [&]
+        {
+            int threads = A.threads > 1 ? A.threads : (int)online_cpus().size();
+            runAtomics(buf1, tiers, threads, A.iters);
+            return true;
+        } },
+        { "c2c", A.c2c, (double)(c2cCpus.size() * c2cCpus.size() + c2cCpus.size()) + 6, 4, {}, [&]
+        {
+            runC2C(c2cCpus, parse_int_list(A.c2cPadding), A.iters);
+            return true;
+        } },
+        { "prefetch", A.prefetch, 60.0 + parse_int_list(A.prefetchDists).size(), A.prefetchKB, {}, [&]
+        {
+            runPrefetch(buf1, A.prefetchKB, A.iters, parse_int_list(A.prefetchDists));
+            return true;
+        } },
+        { "tkernel", !A.tkernel.empty(), 4.0 * tks.size(), tierKB,
+          tkLatency ? vector<size_t>{ ring(A.l1KB), ring(A.l2KB), ring(A.l3KB), ring(A.memKB) }
+                    : vector<size_t>{}, [&]
+        {
+            runTKernels(buf1, buf2, tiers, tks, A.stride, A.iters, A.threads);
+            return true;
+        } },
+        { "loaded", A.loaded, (double)parse_int_list(A.loadedDelays).size() + 1, A.memKB,
+          { ring(A.memKB) }, [&]
+        {
+            runLoaded(buf1, buf2, A.memKB, A.stride, A.iters, A.loadedThreads, A.loadedTraffic,
+                      parse_int_list(A.loadedDelays));
+            return true;
+        } },
+    };
+    bool any = false;
+    for (const Suite& s : suites) any = any || s.requested;
+    suites[0].requested = !any;
+    if (A.all)
+        for (Suite& s : suites)
+            s.requested = s.requested || (strcmp(s.name, "io") != 0 && strcmp(s.name, "tkernel") != 0);
+    if (!select_suites(suites, A.only, A.skip)) return 1;
+    for (const Suite& s : suites)
+    {
+        if (!s.requested) continue;
+        const char* missing = nullptr;
+        if (!strcmp(s.name, "io") && A.ioPath.empty()) missing = "io: needs --io FILE";
+        else if (!strcmp(s.name, "tkernel") && tks.empty()) missing = "tkernel: needs --tkernel NAME,...";
+        else if (!strcmp(s.name, "c2c") && c2cCpus.empty()) missing = "--c2c-cpus selects no usable CPUs";
+        if (missing)
+        {
+            cerr << missing << "\n";
+            return 1;
+        }
+    }
+
+    size_t maxKB = 4;
+    if (A.monitor) maxKB = A.monitorKB;
+    else
+        for (const Suite& s : suites)
+            if (s.requested) maxKB = max(maxKB, s.arenaKB);
+    totalBytes = maxKB * 1024ULL + (1ULL << 21);
 
-    char* buf1 = (char*)alloc_aligned(totalBytes, align);
-    char* buf2 = (char*)alloc_aligned(totalBytes, align);
-    if (!buf1 || !buf2) 
+    b1 = alloc_buffer(totalBytes, A.pages);
+    b2 = alloc_buffer(totalBytes, A.pages);
+    if ((!b1.p || !b2.p) && A.pages != PageKind::Default)
+    {
+        // hugetlb needs reserved pages (vm.nr_hugepages); THP is the next best.
+        PageKind fb = (A.pages == PageKind::Huge2M || A.pages == PageKind::Huge1G)
+                          ? PageKind::THP : PageKind::Default;
+        cerr << "warning: " << page_kind_name(A.pages) << " pages unavailable, using "
+             << page_kind_name(fb) << "\n";
+        free_buffer(b1);
+        free_buffer(b2);
+        A.pages = fb;
+        b1 = alloc_buffer(totalBytes, A.pages);
+        b2 = alloc_buffer(totalBytes, A.pages);
+    }
+    if (!b1.p || !b2.p) 
     {
         cerr << "alloc failed\n";
         return 1;
     }
+    buf1 = b1.p;
+    buf2 = b2.p;
 
-    // warm touch
-    for (size_t off = 0; off < totalBytes; off += 4096) 
+    // Parallel first touch. With --threads N the bandwidth threads' CPUs
+    // touch their own slices (first-touch placement matches the run);
+    // otherwise the CPUs of the first CPU's NUMA node, so single-threaded
+    // tests still see node-local memory.
     {
-        buf1[off] = 1;
-        buf2[off] = 2;
+        vector<int> cpus = online_cpus();
+        if (A.threads <= 1)
+            for (const NumaNode& n : numa_nodes())
+                if (find(n.cpus.begin(), n.cpus.end(), cpus[0]) != n.cpus.end()) cpus = n.cpus;
+        int touchers = A.threads > 1 ? A.threads : (int)cpus.size();
+        touch_parallel(buf1, totalBytes, touchers, cpus);
+        touch_parallel(buf2, totalBytes, touchers, cpus);
     }
 
     cout << "AIDA-like (quick) Cache & Memory Benchmark\n";
+    cout << "Kernel: " << g_kernel->name << "\n";
+    cout << "Timer:  " << g_timer.name << " (" << fixed << setprecision(3) << g_timer.nsPerTick
+         << " ns/tick, overhead " << setprecision(0) << g_timer.overheadTicks << " ticks)";
+    if (g_timer.cpuGHz > 0) cout << ", core ~" << setprecision(2) << g_timer.cpuGHz << " GHz";
+    cout << "\n";
+    const CacheInfo& C = cache_info();
+    cout << "Caches: L1d " << (C.l1.bytes >> 10) << " KB, L2 " << (C.l2.bytes >> 10)
+         << " KB, L3 " << (C.l3.bytes >> 10) << " KB (" << C.source << ")\n";
+    cout << "Tiers:  L1 " << A.l1KB << " KB, L2 " << A.l2KB << " KB, L3 " << A.l3KB
+         << " KB, Memory " << A.memKB << " KB\n";
+    warn_stride_aliasing(A.stride);
+    if (A.threads > 1) cout << "Threads: " << A.threads << " (pinned, totals are aggregate)\n";
+    if (A.counters)
+    {
+        string detail;
+        g_pmcOn = pmc_open(detail);
+        cout << "Counters: " << (g_pmcOn ? "" : "unavailable, ") << detail << "\n";
+    }
+    if (A.pages != PageKind::Default)
+        cout << "Pages: " << page_kind_name(A.pages) << " (" << describe_pages(b1) << ")\n";
+    if (A.rdt)
+    {
+        if (!rdt_setup(A.resctrlGroup, A.catMask, A.mbaPct))
+        {
+            rdt_teardown();
+            return 1;
+        }
+        rdt_report(C.l3.bytes);
+    }
+    RdtSample rdt0 = rdt_sample();
+    auto run0 = clk::now();
+    int failed = 0;
+
+    if (A.monitor)
+    {
+        ostream out(stdoutBuf);
+        runMonitor(out, buf1, A.monitorKB, A.stride, A.monitorInterval, A.monitorCount,
+                   A.monitorBudgetPct, A.monitorNice, A.monitorFormat, A.monitorOut);
+    }
+    else
+    {
+        failed = runSuites(suites, A.timeBudgetSec, A.pipeline, A.threads);
+    }
 
-    Row mem = benchTier("Memory", A.memKB, buf1, buf2, A.iters, A.stride);
-    Row l1  = benchTier("L1", A.l1KB, buf1, buf2, A.iters, A.stride);
-    Row l2  = benchTier("L2", A.l2KB, buf1, buf2, A.iters, A.stride);
-    Row l3  = benchTier("L3", A.l3KB, buf1, buf2, A.iters, A.stride);
+    RdtDelta rdtRun = rdt_delta(rdt0, rdt_sample(),
+                                chrono::duration<double>(clk::now() - run0).count());
+    if (rdtRun.valid)
+    {
+        Row whole;
+        whole.rdt = rdtRun;
+        printRdt("Run", whole);
+        recordRdt("run", rdtRun);
+    }
+    rdt_teardown();
 
-    printRow("Memory", mem);
-    printRow("L1", l1);
-    printRow("L2", l2);
-    printRow("L3", l3);
+    free_buffer(b1);
+    free_buffer(b2);
 
-    free_aligned(buf1);
-    free_aligned(buf2);
+    int regressions = A.compare.empty() ? 0 : compareBaseline(baseline, A.tolerancePct);
+
+    cout.rdbuf(stdoutBuf);
+    if (A.format == "json") writeJson(cout, A);
+    else if (A.format == "csv") writeCsv(cout, A);
 
     if (sink64 == 0xDEADBEEF) 
     {
         cerr << "sink\n";
     }
-    return 0;
+    return failed ? 1 : (regressions ? 2 : 0);
 }